@@ -0,0 +1,328 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "AudioThreadGuard.h"
+#include <cstdlib>
+#include <cerrno>
+#include <new>
+
+// Whether the current thread is inside a ScopedRealtime, and whether it is already reporting a violation (so the report itself is never trapped). With glibc the
+// initial-exec model keeps the first access on a new thread from calling malloc, which would recurse once malloc is replaced below
+#if defined(__GLIBC__)
+ #define AUDIO_THREAD_GUARD_TLS __attribute__((tls_model("initial-exec")))
+#else
+ #define AUDIO_THREAD_GUARD_TLS
+#endif
+static thread_local bool audioThreadIsRealtime AUDIO_THREAD_GUARD_TLS = false;
+static thread_local bool audioThreadIsReporting AUDIO_THREAD_GUARD_TLS = false;
+
+static std::atomic<int> audioThreadViolationCount (0);
+static std::atomic<const char*> audioThreadLastViolation (nullptr);
+static std::atomic<bool> audioThreadAbortOnViolation (false);
+
+AudioThreadGuard::ScopedRealtime::ScopedRealtime()
+{
+    wasRealtime_ = audioThreadIsRealtime;
+   #if BPV_AUDIO_THREAD_GUARD
+    audioThreadIsRealtime = true;
+   #endif
+}
+
+AudioThreadGuard::ScopedRealtime::~ScopedRealtime()
+{
+    audioThreadIsRealtime = wasRealtime_;
+}
+
+bool AudioThreadGuard::isRealtimeThread()
+{
+    return audioThreadIsRealtime;
+}
+
+/*
+  * @brief Report a violation if called on a real-time thread. Does nothing unless BPV_AUDIO_THREAD_GUARD is set
+  * @param Name of the operation, e.g. "operator new"
+*/
+void AudioThreadGuard::check(const char* operation)
+{
+    if (audioThreadIsRealtime && ! audioThreadIsReporting)
+        reportViolation(operation);
+}
+
+/*
+  * @brief Record a violation, and abort if asked to so that a debugger or test stops on the offending call. Does not allocate
+  * @param Name of the operation
+*/
+void AudioThreadGuard::reportViolation(const char* operation)
+{
+    audioThreadIsReporting = true;
+
+    audioThreadViolationCount.fetch_add(1);
+    audioThreadLastViolation.store(operation);
+
+    if (audioThreadAbortOnViolation.load())
+        std::abort();
+
+    audioThreadIsReporting = false;
+}
+
+int AudioThreadGuard::getViolationCount()
+{
+    return audioThreadViolationCount.load();
+}
+
+const char* AudioThreadGuard::getLastViolation()
+{
+    return audioThreadLastViolation.load();
+}
+
+void AudioThreadGuard::resetViolations()
+{
+    audioThreadViolationCount.store(0);
+    audioThreadLastViolation.store(nullptr);
+}
+
+void AudioThreadGuard::setAbortOnViolation(bool shouldAbort)
+{
+    audioThreadAbortOnViolation.store(shouldAbort);
+}
+
+#if BPV_AUDIO_THREAD_GUARD
+ #if defined(__GLIBC__)
+// glibc exports its allocator under __libc_ names, so malloc and friends can be replaced below and the originals still reached
+extern "C"
+{
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* p, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+    void* __libc_valloc(size_t size);
+    void* __libc_pvalloc(size_t size);
+    void __libc_free(void* p);
+}
+
+static inline void* rawAllocate(std::size_t size)                               { return __libc_malloc(size); }
+static inline void* rawAllocateAligned(std::size_t size, std::size_t alignment) { return __libc_memalign(alignment, size); }
+static inline void rawFree(void* p)                                             { __libc_free(p); }
+ #else
+static inline void* rawAllocate(std::size_t size)                               { return std::malloc(size); }
+static inline void rawFree(void* p)                                             { std::free(p); }
+
+static inline void* rawAllocateAligned(std::size_t size, std::size_t alignment)
+{
+    void* p = nullptr;
+    return posix_memalign(&p, alignment < sizeof(void*) ? sizeof(void*) : alignment, size) == 0 ? p : nullptr;
+}
+ #endif
+
+//==============================================================================
+// Replacement global allocation functions. The nothrow and array forms are replaced as well as the plain ones, and the aligned forms below, as libstdc++ does not
+// route the aligned forms through the plain ones
+
+void* operator new (std::size_t size)
+{
+    AudioThreadGuard::check("operator new");
+
+    if (void* p = rawAllocate(size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    AudioThreadGuard::check("operator new[]");
+
+    if (void* p = rawAllocate(size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    AudioThreadGuard::check("operator new");
+    return rawAllocate(size == 0 ? 1 : size);
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    AudioThreadGuard::check("operator new[]");
+    return rawAllocate(size == 0 ? 1 : size);
+}
+
+void operator delete (void* p) noexcept
+{
+    AudioThreadGuard::check("operator delete");
+    rawFree(p);
+}
+
+void operator delete[] (void* p) noexcept
+{
+    AudioThreadGuard::check("operator delete[]");
+    rawFree(p);
+}
+
+void operator delete (void* p, std::size_t) noexcept
+{
+    AudioThreadGuard::check("operator delete");
+    rawFree(p);
+}
+
+void operator delete[] (void* p, std::size_t) noexcept
+{
+    AudioThreadGuard::check("operator delete[]");
+    rawFree(p);
+}
+
+ #if __cpp_aligned_new
+//==============================================================================
+// Over-aligned types, e.g. anything declared alignas(32) for AVX, are allocated through these
+
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    AudioThreadGuard::check("aligned operator new");
+
+    if (void* p = rawAllocateAligned(size == 0 ? 1 : size, (std::size_t)alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    AudioThreadGuard::check("aligned operator new[]");
+
+    if (void* p = rawAllocateAligned(size == 0 ? 1 : size, (std::size_t)alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    AudioThreadGuard::check("aligned operator new");
+    return rawAllocateAligned(size == 0 ? 1 : size, (std::size_t)alignment);
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    AudioThreadGuard::check("aligned operator new[]");
+    return rawAllocateAligned(size == 0 ? 1 : size, (std::size_t)alignment);
+}
+
+void operator delete (void* p, std::align_val_t) noexcept
+{
+    AudioThreadGuard::check("aligned operator delete");
+    rawFree(p);
+}
+
+void operator delete[] (void* p, std::align_val_t) noexcept
+{
+    AudioThreadGuard::check("aligned operator delete[]");
+    rawFree(p);
+}
+
+void operator delete (void* p, std::size_t, std::align_val_t) noexcept
+{
+    AudioThreadGuard::check("aligned operator delete");
+    rawFree(p);
+}
+
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept
+{
+    AudioThreadGuard::check("aligned operator delete[]");
+    rawFree(p);
+}
+
+void operator delete (void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    AudioThreadGuard::check("aligned operator delete");
+    rawFree(p);
+}
+
+void operator delete[] (void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    AudioThreadGuard::check("aligned operator delete[]");
+    rawFree(p);
+}
+ #endif
+
+ #if defined(__GLIBC__)
+//==============================================================================
+// Replacing malloc and friends catches allocations made by C code too, such as JUCE's HeapBlock (i.e. AudioBuffer::setSize), and the aligned allocators catch
+// FFTW's, as fftw_malloc uses memalign on glibc. Only effective when the plugin is linked into the process (e.g. a test runner), not when it is dlopen'ed by a host
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        AudioThreadGuard::check("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        AudioThreadGuard::check("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* p, size_t size)
+    {
+        AudioThreadGuard::check("realloc");
+        return __libc_realloc(p, size);
+    }
+
+    void free(void* p)
+    {
+        AudioThreadGuard::check("free");
+        __libc_free(p);
+    }
+
+    void* memalign(size_t alignment, size_t size)
+    {
+        AudioThreadGuard::check("memalign");
+        return __libc_memalign(alignment, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        AudioThreadGuard::check("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** p, size_t alignment, size_t size)
+    {
+        AudioThreadGuard::check("posix_memalign");
+
+        // The alignment must be a power of 2 and a multiple of sizeof(void*), and *p is left alone on failure
+        if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        void* allocated = __libc_memalign(alignment, size);
+        if (allocated == nullptr)
+            return ENOMEM;
+
+        *p = allocated;
+        return 0;
+    }
+
+    void* valloc(size_t size)
+    {
+        AudioThreadGuard::check("valloc");
+        return __libc_valloc(size);
+    }
+
+    void* pvalloc(size_t size)
+    {
+        AudioThreadGuard::check("pvalloc");
+        return __libc_pvalloc(size);
+    }
+}
+ #endif
+#endif
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+// Debug/test mode that traps heap allocation and locking on the audio thread. When set to 1, every form of the global operator new and delete, aligned ones
+// included (and, on Linux, malloc, the aligned allocators and friends), is replaced with a version that reports a violation if called inside a ScopedRealtime, as
+// are the FFTW planner lock and other entry points that must never run on the audio thread. Off by default, as it replaces process-wide functions
+#ifndef BPV_AUDIO_THREAD_GUARD
+ #define BPV_AUDIO_THREAD_GUARD 0
+#endif
+
+class AudioThreadGuard
+{
+public:
+    // Marks the current thread as real-time for the lifetime of the object (i.e. the body of processBlock)
+    class ScopedRealtime
+    {
+    public:
+        ScopedRealtime();
+        ~ScopedRealtime();
+
+    private:
+        bool wasRealtime_;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtime)
+    };
+
+    static bool isRealtimeThread();
+    static void check(const char* operation);
+    static void reportViolation(const char* operation);
+
+    static int getViolationCount();
+    static const char* getLastViolation();
+    static void resetViolations();
+    static void setAbortOnViolation(bool shouldAbort);
+};
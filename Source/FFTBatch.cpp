@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "FFTBatch.h"
+
+FFTBatch::FFTBatch()
+{
+    transformSize_ = 0;
+    numBins_ = 0;
+    numTransforms_ = 0;
+    partialBatches_ = false;
+    timeDomain_ = nullptr;
+    frequencyDomain_ = nullptr;
+    binStride_ = 0;
+    numForwardPlans_ = 0;
+    numBackwardPlans_ = 0;
+}
+
+/*
+  * @brief Allocate contiguous storage for a batch of real transforms of the same size and create FFTW plans that run over all of them in one call. The planner measures
+  * (and overwrites) the batch arrays, so nothing should be stored in them before this is called
+  * @param Transform size K
+  * @param Number of transforms in the batch, or the most that will be run at once with partial batches
+  * @param Which directions to plan, as a combination of Directions
+  * @param Whether fewer than the whole batch may be transformed at once, which costs one plan per bit of the batch size
+*/
+void FFTBatch::prepare(int transformSize, int numTransforms, int directions, bool partialBatches)
+{
+    release();
+
+    transformSize_ = transformSize;
+    partialBatches_ = partialBatches;
+
+    // The input is purely real, so its spectrum is conjugate symmetric and only the first K/2 + 1 bins need to be stored
+    numBins_ = transformSize_/2 + 1;
+    binStride_ = (numBins_ + 3) & ~3;
+
+    int numPlans = 1;
+    if (partialBatches_)
+    {
+        while ((1 << numPlans) <= numTransforms && numPlans < FFT_BATCH_MAX_PLANS)
+            ++numPlans;
+        numTransforms = jmin(numTransforms, (1 << numPlans) - 1);
+    }
+    numTransforms_ = jmax(1, numTransforms);
+
+    // Utilise FFTW's wrapper functions to allocate memory for the real time domain transforms and the half-spectrum complex transforms
+    timeDomain_ = FFTWP(alloc_real)(numTransforms_ * transformSize_);
+    frequencyDomain_ = FFTWP(alloc_complex)(numTransforms_ * binStride_);
+
+    // Create batched real-to-complex FFT and complex-to-real IFFT plans through FFTW's plan_many_dft_r2c and plan_many_dft_c2r methods. Wisdom from an earlier
+    // session makes this almost instant
+    FFTWPlanner::loadWisdom();
+    const unsigned plannerFlags = FFTWPlanner::getPlannerFlags();
+    const ScopedLock plannerLock (FFTWPlanner::getLock());
+
+    for (int b = 0; b < numPlans; ++b)
+    {
+        const int howMany = partialBatches_ ? 1 << b : numTransforms_;
+
+        if ((directions & forwardTransforms) != 0)
+        {
+            forwardPlans_[b] = FFTWP(plan_many_dft_r2c)(1, &transformSize_, howMany,
+                                     timeDomain_, nullptr, 1, transformSize_,
+                                     frequencyDomain_, nullptr, 1, binStride_, plannerFlags);
+            numForwardPlans_ = b + 1;
+        }
+
+        if ((directions & backwardTransforms) != 0)
+        {
+            backwardPlans_[b] = FFTWP(plan_many_dft_c2r)(1, &transformSize_, howMany,
+                                      frequencyDomain_, nullptr, 1, binStride_,
+                                      timeDomain_, nullptr, 1, transformSize_, plannerFlags);
+            numBackwardPlans_ = b + 1;
+        }
+    }
+}
+
+/*
+  * @brief Destroy the plans and free the batch storage. Does nothing if the batch was never prepared
+*/
+void FFTBatch::release()
+{
+    if (timeDomain_ == nullptr)
+        return;
+
+    {
+        const ScopedLock plannerLock (FFTWPlanner::getLock());
+
+        for (int b = 0; b < numForwardPlans_; ++b)
+            FFTWP(destroy_plan)(forwardPlans_[b]);
+        for (int b = 0; b < numBackwardPlans_; ++b)
+            FFTWP(destroy_plan)(backwardPlans_[b]);
+    }
+    numForwardPlans_ = 0;
+    numBackwardPlans_ = 0;
+
+    FFTWP(free)(timeDomain_);
+    FFTWP(free)(frequencyDomain_);
+    timeDomain_ = nullptr;
+    frequencyDomain_ = nullptr;
+    numTransforms_ = 0;
+}
+
+/*
+  * @brief Forward (r2c) FFT of every transform in the batch, unnormalised
+*/
+void FFTBatch::forward()
+{
+    forward(numTransforms_);
+}
+
+/*
+  * @brief Forward (r2c) FFT of the first numTransforms transforms of the batch
+  * @param Number of transforms. Must be the whole batch unless it was prepared for partial batches
+*/
+void FFTBatch::forward(int numTransforms)
+{
+    jassert(numForwardPlans_ > 0);
+    execute(forwardPlans_, true, numTransforms);
+}
+
+/*
+  * @brief Backward (c2r) IFFT of every transform in the batch, unnormalised. As with any c2r transform, the spectra are overwritten
+*/
+void FFTBatch::backward()
+{
+    backward(numTransforms_);
+}
+
+/*
+  * @brief Backward (c2r) IFFT of the first numTransforms transforms of the batch
+  * @param Number of transforms. Must be the whole batch unless it was prepared for partial batches
+*/
+void FFTBatch::backward(int numTransforms)
+{
+    jassert(numBackwardPlans_ > 0);
+    execute(backwardPlans_, false, numTransforms);
+}
+
+/*
+  * @brief Transform the first numTransforms transforms of the batch, using one batched plan per set bit of numTransforms when partial batches are allowed
+  * @param Forward or backward batched plans
+  * @param True for the forward (r2c) direction
+  * @param Number of transforms
+*/
+void FFTBatch::execute(SpectralPlan* plans, bool forward, int numTransforms)
+{
+    jassert(numTransforms <= numTransforms_);
+
+    if (partialBatches_ == false)
+    {
+        jassert(numTransforms == numTransforms_);
+        FFTWP(execute)(plans[0]);
+        return;
+    }
+
+    const int numPlans = forward ? numForwardPlans_ : numBackwardPlans_;
+    int index = 0;
+
+    for (int b = numPlans - 1; b >= 0; --b)
+    {
+        if ((numTransforms & (1 << b)) == 0)
+            continue;
+
+        // New-array execution on a later part of the batch. The spacing of the transforms keeps every offset as aligned as the arrays the plans were made with
+        if (forward)
+            FFTWP(execute_dft_r2c)(plans[b], getTimeDomain(index), getFrequencyDomain(index));
+        else
+            FFTWP(execute_dft_c2r)(plans[b], getFrequencyDomain(index), getTimeDomain(index));
+
+        index += 1 << b;
+    }
+}
+
+/*
+  * @brief Return the K real samples of one transform in the batch
+  * @param Transform number
+*/
+SpectralSample* FFTBatch::getTimeDomain(int index) const
+{
+    return timeDomain_ + index * transformSize_;
+}
+
+/*
+  * @brief Return the first K/2 + 1 bins of the spectrum of one transform in the batch
+  * @param Transform number
+*/
+SpectralComplex* FFTBatch::getFrequencyDomain(int index) const
+{
+    return frequencyDomain_ + index * binStride_;
+}
+
+/*
+  * @brief Transform size K the batch was prepared with
+*/
+int FFTBatch::getTransformSize() const
+{
+    return transformSize_;
+}
+
+/*
+  * @brief Number of bins kept for each transform, K/2 + 1
+*/
+int FFTBatch::getNumBins() const
+{
+    return numBins_;
+}
+
+/*
+  * @brief Number of transforms the batch holds
+*/
+int FFTBatch::getNumTransforms() const
+{
+    return numTransforms_;
+}
+
+/*
+  * @brief Whether the batch has storage and plans
+*/
+bool FFTBatch::isPrepared() const
+{
+    return timeDomain_ != nullptr;
+}
+
+FFTBatch::~FFTBatch()
+{
+    release();
+}
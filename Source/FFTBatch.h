@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralTypes.h"
+#include "FFTWPlanner.h"
+
+#define FFT_BATCH_MAX_PLANS 16
+
+class FFTBatch
+{
+public:
+    enum Directions
+    {
+        forwardTransforms = 1,
+        backwardTransforms = 2,
+        bothDirections = forwardTransforms | backwardTransforms
+    };
+
+    FFTBatch();
+    ~FFTBatch();
+
+    void prepare(int transformSize, int numTransforms, int directions = bothDirections, bool partialBatches = false);
+    void release();
+    void forward();
+    void forward(int numTransforms);
+    void backward();
+    void backward(int numTransforms);
+
+    SpectralSample* getTimeDomain(int index) const;
+    SpectralComplex* getFrequencyDomain(int index) const;
+    int getTransformSize() const;
+    int getNumBins() const;
+    int getNumTransforms() const;
+    bool isPrepared() const;
+
+private:
+    void execute(SpectralPlan* plans, bool forward, int numTransforms);
+
+    int transformSize_;
+    int numBins_;
+    int numTransforms_;
+    bool partialBatches_;
+
+    // Transform j of the batch lives at timeDomain_ + j*K and frequencyDomain_ + j*binStride_, all in two contiguous arrays
+    SpectralSample* timeDomain_;
+    SpectralComplex* frequencyDomain_;
+    // Bins rounded up to a multiple of 4, so every transform keeps the (SIMD) alignment of the first
+    int binStride_;
+
+    // With partial batches, plan b transforms 2^b transforms so that any number of them is covered by one plan per set bit. Otherwise plan 0 transforms the whole batch
+    SpectralPlan forwardPlans_[FFT_BATCH_MAX_PLANS];
+    SpectralPlan backwardPlans_[FFT_BATCH_MAX_PLANS];
+    int numForwardPlans_;
+    int numBackwardPlans_;
+
+    JUCE_DECLARE_NON_COPYABLE (FFTBatch)
+};
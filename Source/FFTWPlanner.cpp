@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "FFTWPlanner.h"
+
+// Process-wide planner state, only touched with the lock held
+static bool fftwWisdomLoaded = false;
+static String fftwSavedWisdom;
+static unsigned fftwPlannerFlags = FFTW_MEASURE;
+
+/*
+  * @brief Lock that serialises every call into FFTW's planner across all instances of the plugin
+*/
+CriticalSection& FFTWPlanner::getLock()
+{
+    // Planning can take seconds with FFTW_MEASURE, so the audio thread must never wait on this lock
+    AudioThreadGuard::check("FFTW planner lock");
+
+    static CriticalSection plannerLock;
+    return plannerLock;
+}
+
+/*
+  * @brief Planner rigour used for every plan (FFTW_MEASURE by default). Plans found in the wisdom file are reused at no cost, so only the first load pays for the measurement
+*/
+unsigned FFTWPlanner::getPlannerFlags()
+{
+    const ScopedLock lock (getLock());
+    return fftwPlannerFlags;
+}
+
+/*
+  * @brief Change the planner rigour for plans made after this call
+  * @param FFTW_ESTIMATE, FFTW_MEASURE, FFTW_PATIENT or FFTW_EXHAUSTIVE
+*/
+void FFTWPlanner::setPlannerFlags(unsigned flags)
+{
+    const ScopedLock lock (getLock());
+    fftwPlannerFlags = flags;
+}
+
+File FFTWPlanner::getWisdomFile()
+{
+    return File::getSpecialLocation(File::userApplicationDataDirectory).getChildFile(FFTW_WISDOM_FOLDER).getChildFile(FFTW_WISDOM_FILE);
+}
+
+/*
+  * @brief Import the wisdom file into FFTW, once per process. Call before making plans
+*/
+void FFTWPlanner::loadWisdom()
+{
+    const ScopedLock lock (getLock());
+
+    if (fftwWisdomLoaded)
+        return;
+
+    fftwWisdomLoaded = true;
+
+    const File wisdomFile = getWisdomFile();
+    if (wisdomFile.existsAsFile())
+    {
+        const String wisdom = wisdomFile.loadFileAsString();
+
+        // A corrupt or out of date file is ignored, and replaced on the next save
+        if (FFTWP(import_wisdom_from_string)(wisdom.toRawUTF8()) != 0)
+            fftwSavedWisdom = wisdom;
+    }
+}
+
+/*
+  * @brief Write FFTW's accumulated wisdom back to the file, if planning has added to it since it was last loaded or saved. Call after making plans
+*/
+void FFTWPlanner::saveWisdom()
+{
+    const ScopedLock lock (getLock());
+
+    char* exported = FFTWP(export_wisdom_to_string)();
+    if (exported == nullptr)
+        return;
+
+    const String wisdom (exported);
+    // FFTW allocated the string, so it must be freed with its own deallocator
+    FFTWP(free)(exported);
+
+    if (wisdom == fftwSavedWisdom)
+        return;
+
+    // replaceWithText writes to a temporary file and moves it into place, so another process never sees a half-written file
+    const File wisdomFile = getWisdomFile();
+    if (wisdomFile.getParentDirectory().createDirectory() && wisdomFile.replaceWithText(wisdom))
+        fftwSavedWisdom = wisdom;
+}
@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralTypes.h"
+#include "AudioThreadGuard.h"
+
+// Name of the wisdom file, kept in a folder of the user's application data directory. Single and double precision wisdom are not interchangeable, so each has its own file
+#define FFTW_WISDOM_FOLDER "DAFX Binaural Phase Vocoder"
+#if BPV_DOUBLE_PRECISION
+ #define FFTW_WISDOM_FILE "fftw_wisdom_double.txt"
+#else
+ #define FFTW_WISDOM_FILE "fftwf_wisdom_float.txt"
+#endif
+
+class FFTWPlanner
+{
+public:
+    // FFTW's planner (plan creation and destruction, and wisdom import/export) is not thread-safe, and its state is shared by every instance of the plugin in the process.
+    // Hold this lock around any of those calls. Executing an existing plan does not need it
+    static CriticalSection& getLock();
+
+    static unsigned getPlannerFlags();
+    static void setPlannerFlags(unsigned flags);
+
+    static void loadWisdom();
+    static void saveWisdom();
+
+private:
+    static File getWisdomFile();
+};
@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "FractionalDelayLine.h"
+#include "SpectralLanes.h"
+
+/*
+  * @brief Third-order Lagrange interpolation weights for reading a delay of D + f samples, from the samples delayed by D + 2, D + 1, D and D - 1 (oldest first)
+  * @param Fractional part f of the delay, in [0, 1)
+  * @param Gain folded into the weights
+  * @param The four weights
+*/
+static void lagrangeCoefficients(double fraction, float gain, float* coefficients)
+{
+    const double f = fraction;
+    coefficients[0] = (float)(gain * (f + 1.0) * f * (f - 1.0) / 6.0);
+    coefficients[1] = (float)(gain * -(f + 1.0) * f * (f - 2.0) / 2.0);
+    coefficients[2] = (float)(gain * (f + 1.0) * (f - 1.0) * (f - 2.0) / 2.0);
+    coefficients[3] = (float)(gain * -f * (f - 1.0) * (f - 2.0) / 6.0);
+}
+
+/*
+  * @brief Interpolate a whole vector of output samples at a time while the delay holds still: every output is the same four-tap FIR over the oldest-first window that
+  * starts at its own input
+  * @return First output sample not computed, as only whole vectors are
+*/
+template <typename L>
+static int lagrangeLanes(const float* window, const float* coefficients, float* output, int start, int numSamples)
+{
+    typedef typename L::Vec Vec;
+
+    const Vec c0 = L::set1(coefficients[0]);
+    const Vec c1 = L::set1(coefficients[1]);
+    const Vec c2 = L::set1(coefficients[2]);
+    const Vec c3 = L::set1(coefficients[3]);
+
+    int n = start;
+    for (; n + L::width <= numSamples; n += L::width)
+    {
+        const float* x = window + n;
+        Vec sum = L::mul(c0, L::load(x));
+        sum = L::add(sum, L::mul(c1, L::load(x + 1)));
+        sum = L::add(sum, L::mul(c2, L::load(x + 2)));
+        sum = L::add(sum, L::mul(c3, L::load(x + 3)));
+        L::store(output + n, sum);
+    }
+    return n;
+}
+
+//==============================================================================
+FractionalDelayLine::FractionalDelayLine()
+{
+    bufferLength_ = 0;
+    bufferMask_ = 0;
+    maximumBlockSize_ = 0;
+    maximumDelay_ = FRACTIONAL_DELAY_MIN_SAMPLES;
+
+    for (int channel = 0; channel < FRACTIONAL_DELAY_MAX_CHANNELS; ++channel)
+    {
+        writePosition_[channel] = 0;
+        currentDelay_[channel] = FRACTIONAL_DELAY_MIN_SAMPLES;
+        targetDelay_[channel] = FRACTIONAL_DELAY_MIN_SAMPLES;
+    }
+}
+
+/*
+  * @brief Allocate each channel's delay buffer: the smallest power of two long enough that a whole piece of a block can be written before any of it is read back at the
+  * longest delay
+  * @param Number of channels, up to FRACTIONAL_DELAY_MAX_CHANNELS
+  * @param Longest delay that will be asked for, in samples
+  * @param Largest block processed at once
+*/
+void FractionalDelayLine::prepare(int numChannels, int maximumDelay, int maximumBlockSize)
+{
+    jassert(numChannels <= FRACTIONAL_DELAY_MAX_CHANNELS);
+
+    maximumBlockSize_ = jlimit(1, FRACTIONAL_DELAY_MAX_BLOCK, maximumBlockSize);
+    maximumDelay_ = jmax(FRACTIONAL_DELAY_MIN_SAMPLES, (double)maximumDelay);
+    bufferLength_ = nextPowerOfTwo((int)std::ceil(maximumDelay_) + maximumBlockSize_ + FRACTIONAL_DELAY_NUM_TAPS);
+    bufferMask_ = bufferLength_ - 1;
+
+    buffer_.setSize(jmin(numChannels, FRACTIONAL_DELAY_MAX_CHANNELS), bufferLength_ + FRACTIONAL_DELAY_NUM_TAPS - 1);
+    reset();
+}
+
+/*
+  * @brief Clear the delay buffers and jump straight to each channel's target delay
+*/
+void FractionalDelayLine::reset()
+{
+    buffer_.clear();
+
+    for (int channel = 0; channel < FRACTIONAL_DELAY_MAX_CHANNELS; ++channel)
+    {
+        writePosition_[channel] = 0;
+        currentDelay_[channel] = targetDelay_[channel];
+    }
+}
+
+/*
+  * @brief Set the delay the channel glides to over the next block, so the read position never jumps
+  * @param Channel
+  * @param Delay in samples, which need not be whole. Clamped to [FRACTIONAL_DELAY_MIN_SAMPLES, maximum delay]
+*/
+void FractionalDelayLine::setDelay(int channel, double delaySamples)
+{
+    targetDelay_[channel] = jlimit(FRACTIONAL_DELAY_MIN_SAMPLES, maximumDelay_, delaySamples);
+}
+
+/*
+  * @brief Delay one channel in place. The delay moves linearly, sample by sample, from where the last block left it to the target set by setDelay
+  * @param Channel
+  * @param Samples to delay, overwritten with the delayed samples
+  * @param Number of samples
+  * @param Gain applied to the output
+*/
+void FractionalDelayLine::process(int channel, float* data, int numSamples, float gain)
+{
+    if (numSamples <= 0)
+        return;
+
+    const double startDelay = currentDelay_[channel];
+    const double delayIncrement = (targetDelay_[channel] - startDelay) / numSamples;
+
+    // Blocks longer than the buffer was prepared for are worked through in pieces, with the glide carried across them
+    for (int offset = 0; offset < numSamples; offset += maximumBlockSize_)
+    {
+        const int blockSize = jmin(maximumBlockSize_, numSamples - offset);
+        write(channel, data + offset, blockSize);
+        read(channel, data + offset, blockSize, startDelay + delayIncrement * offset, delayIncrement, gain);
+    }
+
+    currentDelay_[channel] = targetDelay_[channel];
+}
+
+/*
+  * @brief Store a block of input samples at the channel's write position, as at most two copies either side of the end of the buffer
+*/
+void FractionalDelayLine::write(int channel, const float* data, int numSamples)
+{
+    float* delayData = buffer_.getWritePointer(channel);
+    const int position = writePosition_[channel];
+    const int firstSegment = jmin(numSamples, bufferLength_ - position);
+
+    FloatVectorOperations::copy(delayData + position, data, firstSegment);
+    FloatVectorOperations::copy(delayData, data + firstSegment, numSamples - firstSegment);
+
+    // Keep the repeat of the start of the buffer after its end up to date
+    FloatVectorOperations::copy(delayData + bufferLength_, delayData, FRACTIONAL_DELAY_NUM_TAPS - 1);
+
+    writePosition_[channel] = (position + numSamples) & bufferMask_;
+}
+
+/*
+  * @brief Read the block just written back out at the delay, interpolating between samples
+  * @param Channel
+  * @param Output samples
+  * @param Number of samples, all of which have already been written
+  * @param Delay before the first sample of the block
+  * @param Change in delay per sample
+  * @param Gain applied to the output
+*/
+void FractionalDelayLine::read(int channel, float* data, int numSamples, double startDelay, double delayIncrement, float gain) const
+{
+    const float* delayData = buffer_.getReadPointer(channel);
+    const int blockStart = (writePosition_[channel] - numSamples) & bufferMask_;
+    float coefficients[FRACTIONAL_DELAY_NUM_TAPS];
+
+    // While the delay holds still the weights are the same for every sample, so whole vectors of outputs are interpolated at once. The oldest-first windows run in a
+    // row up to the end of the buffer, then carry on from its start
+    if (delayIncrement == 0.0)
+    {
+        const int wholeDelay = (int)startDelay;
+        lagrangeCoefficients(startDelay - wholeDelay, gain, coefficients);
+
+        const int windowStart = (blockStart - wholeDelay - 2) & bufferMask_;
+        const int firstSegment = jmin(numSamples, bufferLength_ - windowStart);
+
+        const int n = lagrangeLanes<NativeFloatLanes>(delayData + windowStart, coefficients, data, 0, firstSegment);
+        lagrangeLanes<TailFloatLanes>(delayData + windowStart, coefficients, data, n, firstSegment);
+
+        const int m = lagrangeLanes<NativeFloatLanes>(delayData, coefficients, data + firstSegment, 0, numSamples - firstSegment);
+        lagrangeLanes<TailFloatLanes>(delayData, coefficients, data + firstSegment, m, numSamples - firstSegment);
+        return;
+    }
+
+    // Otherwise the weights are worked out again for every sample, as the delay glides
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double delay = startDelay + delayIncrement * (i + 1);
+        const int wholeDelay = (int)delay;
+        lagrangeCoefficients(delay - wholeDelay, gain, coefficients);
+
+        const float* window = delayData + ((blockStart + i - wholeDelay - 2) & bufferMask_);
+        data[i] = coefficients[0] * window[0] + coefficients[1] * window[1] + coefficients[2] * window[2] + coefficients[3] * window[3];
+    }
+}
+
+/*
+  * @brief Delay reached at the end of the last block, in samples
+*/
+double FractionalDelayLine::getDelay(int channel) const
+{
+    return currentDelay_[channel];
+}
+
+FractionalDelayLine::~FractionalDelayLine()
+{
+
+}
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#define FRACTIONAL_DELAY_MAX_CHANNELS 2
+// Third-order Lagrange interpolation, read from the four samples around each delayed position
+#define FRACTIONAL_DELAY_NUM_TAPS 4
+// The interpolator needs one sample newer than the delayed position, so no delay can be shorter than this
+#define FRACTIONAL_DELAY_MIN_SAMPLES 1.0
+// Longest run of samples written before they are read back. Longer blocks are worked through in pieces, so the buffer stays small whatever the host block size
+#define FRACTIONAL_DELAY_MAX_BLOCK 256
+
+class FractionalDelayLine
+{
+public:
+    FractionalDelayLine();
+    ~FractionalDelayLine();
+
+    void prepare(int numChannels, int maximumDelay, int maximumBlockSize);
+    void reset();
+    void setDelay(int channel, double delaySamples);
+    void process(int channel, float* data, int numSamples, float gain);
+    double getDelay(int channel) const;
+
+private:
+    void write(int channel, const float* data, int numSamples);
+    void read(int channel, float* data, int numSamples, double startDelay, double delayIncrement, float gain) const;
+
+    // Each channel's most recent samples, written in a circle at writePosition_. The length is a power of two, so positions wrap with bufferMask_, and the first
+    // FRACTIONAL_DELAY_NUM_TAPS - 1 samples are repeated after the end so the interpolator can always read its taps in a row
+    AudioSampleBuffer buffer_;
+    int bufferLength_;
+    int bufferMask_;
+    int writePosition_[FRACTIONAL_DELAY_MAX_CHANNELS];
+    int maximumBlockSize_;
+    double maximumDelay_;
+
+    // Delay reached at the end of the last block, and the delay the next block glides to one sample at a time
+    double currentDelay_[FRACTIONAL_DELAY_MAX_CHANNELS];
+    double targetDelay_[FRACTIONAL_DELAY_MAX_CHANNELS];
+
+    JUCE_DECLARE_NON_COPYABLE (FractionalDelayLine)
+};
@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRIRGrid.h"
+
+HRIRGrid::HRIRGrid()
+{
+    numAzimuths_ = 0;
+    numElevations_ = 0;
+}
+
+/*
+  * @brief Arrange the bank's HRIRs into the grid, from the directions in their resource names. Allocates, so must not be called on the audio thread
+  * @param The bank holding the HRIRs, already built
+*/
+void HRIRGrid::build(const IRBank& irBank)
+{
+    azimuths_.clear();
+    elevations_.clear();
+    cells_.clear();
+
+    // Every distinct azimuth and elevation in the bank becomes a grid line
+    double azimuth, elevation;
+    for (int i = 0; i < irBank.getNumImpulses(); ++i)
+    {
+        if (irBank.getDirection(i, azimuth, elevation))
+        {
+            addGridLine(azimuths_, std::fmod(azimuth + 360.0, 360.0));
+            addGridLine(elevations_, elevation);
+        }
+    }
+
+    numAzimuths_ = azimuths_.size();
+    numElevations_ = elevations_.size();
+    if (numAzimuths_ == 0)
+        return;
+
+    azimuths_.add(azimuths_.getFirst() + 360.0);
+    cells_.insertMultiple(0, -1, numElevations_ * numAzimuths_);
+
+    // Place each HRIR at its grid point. If two share a direction, the first is kept
+    for (int i = 0; i < irBank.getNumImpulses(); ++i)
+    {
+        if (irBank.getDirection(i, azimuth, elevation))
+        {
+            const int column = azimuths_.indexOf(std::fmod(azimuth + 360.0, 360.0));
+            const int row = elevations_.indexOf(elevation);
+
+            if (cells_[row * numAzimuths_ + column] < 0)
+                cells_.set(row * numAzimuths_ + column, i);
+        }
+    }
+
+    // Fill the points no HRIR was measured at from the nearest azimuth measured at the same elevation. At the poles, where a single HRIR is measured, this is every point
+    // on the row, as the direction is the same whatever the azimuth
+    for (int row = 0; row < numElevations_; ++row)
+    {
+        Array<int> filledRow;
+        for (int column = 0; column < numAzimuths_; ++column)
+        {
+            int nearest = -1;
+            double nearestDistance = 360.0;
+
+            for (int other = 0; other < numAzimuths_; ++other)
+            {
+                const double difference = std::abs(azimuths_[other] - azimuths_[column]);
+                const double distance = jmin(difference, 360.0 - difference);
+
+                if (cells_[row * numAzimuths_ + other] >= 0 && distance < nearestDistance)
+                {
+                    nearest = cells_[row * numAzimuths_ + other];
+                    nearestDistance = distance;
+                }
+            }
+            filledRow.add(nearest);
+        }
+
+        for (int column = 0; column < numAzimuths_; ++column)
+            cells_.set(row * numAzimuths_ + column, filledRow[column]);
+    }
+
+    buildBracketTable(azimuths_, 360.0, numAzimuths_ - 1, azimuthTable_);
+    buildBracketTable(elevations_, elevations_.getLast() - elevations_.getFirst(), jmax(0, numElevations_ - 2), elevationTable_);
+}
+
+/*
+  * @brief Insert an angle into a sorted list of grid lines, unless it is already there
+*/
+void HRIRGrid::addGridLine(Array<double>& gridLines, double angle)
+{
+    if (gridLines.indexOf(angle) < 0)
+        gridLines.addUsingDefaultSort(angle);
+}
+
+/*
+  * @brief Fill a table with the index of the last grid line at or below each step from the first grid line, up to the given span
+  * @param Sorted grid lines
+  * @param Span of angles covered by the table, in degrees
+  * @param Largest index to store, so that the next grid line always exists
+  * @param Table to fill
+*/
+void HRIRGrid::buildBracketTable(const Array<double>& gridLines, double span, int maximumIndex, Array<int>& table)
+{
+    table.clear();
+
+    const int tableSize = (int)std::ceil(span * HRIR_GRID_TABLE_RESOLUTION) + 1;
+    int index = 0;
+
+    for (int step = 0; step < tableSize; ++step)
+    {
+        const double angle = gridLines.getFirst() + (double)step / HRIR_GRID_TABLE_RESOLUTION;
+
+        while (index < maximumIndex && gridLines[index + 1] <= angle)
+            ++index;
+
+        table.add(index);
+    }
+}
+
+/*
+  * @brief Whether build has found any HRIRs to index
+*/
+bool HRIRGrid::isBuilt() const
+{
+    return numAzimuths_ > 0;
+}
+
+/*
+  * @brief Find the four HRIRs enclosing a direction and their bilinear interpolation weights, in constant time. Does not allocate
+  * @param Azimuth in radians, between -π and π as sent by the GUI
+  * @param Elevation in degrees, limited to the grid's range
+*/
+HRIRSelection HRIRGrid::lookup(double azimuth, double elevation) const
+{
+    jassert(isBuilt());
+
+    // As the azimuth reading wraps around 0 radians (i.e. goes from 0 to π, and then from -π back to 0), unwrap it to degrees from the first grid line onwards
+    const double firstAzimuth = azimuths_.getUnchecked(0);
+    double azimuthDegrees = rad2deg(azimuth) - firstAzimuth;
+    azimuthDegrees = azimuthDegrees - 360.0 * std::floor(azimuthDegrees / 360.0) + firstAzimuth;
+
+    const double firstElevation = elevations_.getUnchecked(0);
+    const double elevationDegrees = jlimit(firstElevation, elevations_.getUnchecked(numElevations_ - 1), elevation);
+
+    // The table gives the grid line at or below the angle rounded down to its resolution; the angle itself can only be past the next grid line as well
+    int column = azimuthTable_.getUnchecked(jlimit(0, azimuthTable_.size() - 1, (int)((azimuthDegrees - firstAzimuth) * HRIR_GRID_TABLE_RESOLUTION)));
+    column += (column < numAzimuths_ - 1 && azimuthDegrees >= azimuths_.getUnchecked(column + 1)) ? 1 : 0;
+
+    int row = elevationTable_.getUnchecked(jlimit(0, elevationTable_.size() - 1, (int)((elevationDegrees - firstElevation) * HRIR_GRID_TABLE_RESOLUTION)));
+    row += (row < numElevations_ - 2 && elevationDegrees >= elevations_.getUnchecked(row + 1)) ? 1 : 0;
+
+    // A single elevation (or a single azimuth, which wraps onto itself) has no neighbour to interpolate towards
+    const int nextColumn = (column + 1) % numAzimuths_;
+    const int nextRow = jmin(row + 1, numElevations_ - 1);
+
+    const double azimuthSpan = azimuths_.getUnchecked(column + 1) - azimuths_.getUnchecked(column);
+    const double elevationSpan = elevations_.getUnchecked(nextRow) - elevations_.getUnchecked(row);
+    const double azimuthFraction = jlimit(0.0, 1.0, (azimuthDegrees - azimuths_.getUnchecked(column)) / azimuthSpan);
+    const double elevationFraction = elevationSpan > 0.0 ? jlimit(0.0, 1.0, (elevationDegrees - elevations_.getUnchecked(row)) / elevationSpan) : 0.0;
+
+    HRIRSelection selection;
+    selection.impulses[lowerLeft] = cells_.getUnchecked(row * numAzimuths_ + column);
+    selection.impulses[upperLeft] = cells_.getUnchecked(nextRow * numAzimuths_ + column);
+    selection.impulses[lowerRight] = cells_.getUnchecked(row * numAzimuths_ + nextColumn);
+    selection.impulses[upperRight] = cells_.getUnchecked(nextRow * numAzimuths_ + nextColumn);
+
+    selection.weights[lowerLeft] = (1.0 - azimuthFraction) * (1.0 - elevationFraction);
+    selection.weights[upperLeft] = (1.0 - azimuthFraction) * elevationFraction;
+    selection.weights[lowerRight] = azimuthFraction * (1.0 - elevationFraction);
+    selection.weights[upperRight] = azimuthFraction * elevationFraction;
+
+    return selection;
+}
+
+/*
+  * @brief Number of distinct azimuths in the grid
+*/
+int HRIRGrid::getNumAzimuths() const
+{
+    return numAzimuths_;
+}
+
+/*
+  * @brief Number of distinct elevations in the grid
+*/
+int HRIRGrid::getNumElevations() const
+{
+    return numElevations_;
+}
+
+HRIRGrid::~HRIRGrid()
+{
+}
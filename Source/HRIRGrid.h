@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRBank.h"
+#include "Util.h"
+
+// Entries per degree of the tables that bracket an angle between two grid lines. Grid lines must be further apart than this
+#define HRIR_GRID_TABLE_RESOLUTION 10
+#define HRIR_GRID_NUM_NEIGHBOURS 4
+
+// The HRIRs surrounding a direction, and the bilinear weights of each
+struct HRIRSelection
+{
+    int impulses[HRIR_GRID_NUM_NEIGHBOURS];
+    double weights[HRIR_GRID_NUM_NEIGHBOURS];
+};
+
+// Spatial index over the HRIR bank. The bank's directions are arranged into a regular table of azimuth and elevation grid lines (which need not be evenly spaced),
+// so that the four HRIRs enclosing any direction are found in constant time
+class HRIRGrid
+{
+public:
+    // Order of the neighbours in HRIRSelection: lower/upper elevation, and left/right (lower/higher) azimuth
+    enum Neighbour
+    {
+        lowerLeft = 0,
+        upperLeft,
+        lowerRight,
+        upperRight
+    };
+
+    HRIRGrid();
+    ~HRIRGrid();
+
+    void build(const IRBank& irBank);
+    bool isBuilt() const;
+    HRIRSelection lookup(double azimuth, double elevation) const;
+
+    int getNumAzimuths() const;
+    int getNumElevations() const;
+
+private:
+    static void addGridLine(Array<double>& gridLines, double angle);
+    static void buildBracketTable(const Array<double>& gridLines, double span, int maximumIndex, Array<int>& table);
+
+    // Sorted grid lines in degrees. Azimuths wrap around, so the first is repeated 360° on at the end
+    Array<double> azimuths_;
+    Array<double> elevations_;
+    int numAzimuths_;
+    int numElevations_;
+
+    // HRIR list number at each grid point, laid out as [elevation][azimuth]
+    Array<int> cells_;
+
+    // Index of the grid line at or below each angle, in steps of 1/HRIR_GRID_TABLE_RESOLUTION degrees from the first grid line
+    Array<int> azimuthTable_;
+    Array<int> elevationTable_;
+
+    JUCE_DECLARE_NON_COPYABLE (HRIRGrid)
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFBlendKernels.h"
+#include "SpectralLanes.h"
+
+/*
+  * @brief Blend bins [start, end) in lanes: a weighted sum of the split real/imaginary spectra, rotated by each bin's delay phase
+  * @return First bin not processed, as only whole vectors are
+*/
+template <typename L>
+static int blendLanes(const SpectralSample* const* real, const SpectralSample* const* imag, const SpectralSample* weights, int numSpectra,
+                      int start, int end, double delayPhaseIncrement, SpectralComplex* output)
+{
+    typedef typename L::Vec Vec;
+
+    // Bin offsets of the lanes within a vector
+    static const SpectralSample laneOffsets[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    const Vec offsets = L::load(laneOffsets);
+    const Vec increment = L::set1(delayPhaseIncrement);
+
+    Vec w[HRTF_BLEND_MAX_SPECTRA];
+    for (int n = 0; n < numSpectra; ++n)
+    {
+        w[n] = L::set1(weights[n]);
+    }
+
+    int i = start;
+    for (; i + L::width <= end; i += L::width)
+    {
+        Vec blendRe = L::mul(w[0], L::load(real[0] + i));
+        Vec blendIm = L::mul(w[0], L::load(imag[0] + i));
+
+        for (int n = 1; n < numSpectra; ++n)
+        {
+            blendRe = L::add(blendRe, L::mul(w[n], L::load(real[n] + i)));
+            blendIm = L::add(blendIm, L::mul(w[n], L::load(imag[n] + i)));
+        }
+
+        // The delay is a linear phase, so each bin's rotation is computed from its index directly rather than accumulated from the previous bin
+        Vec sine, cosine;
+        sinCos<L>(L::mul(L::add(L::set1((double)i), offsets), increment), sine, cosine, true);
+
+        L::storeComplex(&output[i][0], L::sub(L::mul(blendRe, cosine), L::mul(blendIm, sine)), L::add(L::mul(blendRe, sine), L::mul(blendIm, cosine)));
+    }
+    return i;
+}
+
+//==============================================================================
+/*
+  * @brief Blend spectra stored as separate real and imaginary arrays into one interleaved spectrum, delayed by a linear phase: output[k] = Σ w[n] X[n][k] e^(j k θ).
+  * Works on as many bins per instruction as the native lanes hold
+  * @param Real parts of each spectrum
+  * @param Imaginary parts of each spectrum
+  * @param Weight of each spectrum
+  * @param Number of spectra, at most HRTF_BLEND_MAX_SPECTRA
+  * @param Number of bins
+  * @param Phase θ added per bin, in radians (i.e. -2πd/K for a delay of d samples at transform size K)
+  * @param Interleaved output bins, ready for a c2r transform
+*/
+void HRTFBlendKernels::blend(const SpectralSample* const* real, const SpectralSample* const* imag, const SpectralSample* weights, int numSpectra,
+                             int numBins, double delayPhaseIncrement, SpectralComplex* output)
+{
+    jassert(numSpectra > 0 && numSpectra <= HRTF_BLEND_MAX_SPECTRA);
+
+    const int i = blendLanes<NativeLanes>(real, imag, weights, numSpectra, 0, numBins, delayPhaseIncrement, output);
+    blendLanes<TailLanes>(real, imag, weights, numSpectra, i, numBins, delayPhaseIncrement, output);
+}
+
+/*
+  * @brief Scalar reference for blend, bin by bin with libm's cos and sin in double precision. Same parameters as blend
+*/
+void HRTFBlendKernels::blendReference(const SpectralSample* const* real, const SpectralSample* const* imag, const SpectralSample* weights, int numSpectra,
+                                      int numBins, double delayPhaseIncrement, SpectralComplex* output)
+{
+    for (int i = 0; i < numBins; i++)
+    {
+        double blendRe = 0.0;
+        double blendIm = 0.0;
+
+        for (int n = 0; n < numSpectra; ++n)
+        {
+            blendRe += (double)weights[n] * real[n][i];
+            blendIm += (double)weights[n] * imag[n][i];
+        }
+
+        const double phase = i * delayPhaseIncrement;
+        output[i][0] = (SpectralSample)(blendRe * std::cos(phase) - blendIm * std::sin(phase));
+        output[i][1] = (SpectralSample)(blendRe * std::sin(phase) + blendIm * std::cos(phase));
+    }
+}
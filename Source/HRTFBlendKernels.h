@@ -0,0 +1,27 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralTypes.h"
+#include "IRBank.h"
+
+// Largest number of spectra blended at once
+#define HRTF_BLEND_MAX_SPECTRA 4
+
+class HRTFBlendKernels
+{
+public:
+    static void blend(const SpectralSample* const* real, const SpectralSample* const* imag, const SpectralSample* weights, int numSpectra,
+                      int numBins, double delayPhaseIncrement, SpectralComplex* output);
+    static void blendReference(const SpectralSample* const* real, const SpectralSample* const* imag, const SpectralSample* weights, int numSpectra,
+                               int numBins, double delayPhaseIncrement, SpectralComplex* output);
+};
@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFConvolver.h"
+#include "SpectralLanes.h"
+
+/*
+  * @brief Direct-form FIR over whole vectors of output samples: each coefficient is broadcast and multiplied with the inputs it meets at every lane's output. Four vectors
+  * of outputs are worked on at once, so each broadcast feeds four independent accumulators
+  * @return First output sample not computed, as only whole vectors are
+*/
+template <typename L>
+static int firLanes(const float* input, const float* reversedCoefficients, int numTaps, float* output, int start, int numSamples)
+{
+    typedef typename L::Vec Vec;
+
+    int n = start;
+    for (; n + 4 * L::width <= numSamples; n += 4 * L::width)
+    {
+        const float* x = input + n;
+        Vec sum0 = L::set1(0.0), sum1 = L::set1(0.0), sum2 = L::set1(0.0), sum3 = L::set1(0.0);
+
+        for (int k = 0; k < numTaps; ++k)
+        {
+            const Vec h = L::set1(reversedCoefficients[k]);
+            sum0 = L::add(sum0, L::mul(h, L::load(x + k)));
+            sum1 = L::add(sum1, L::mul(h, L::load(x + k + L::width)));
+            sum2 = L::add(sum2, L::mul(h, L::load(x + k + 2 * L::width)));
+            sum3 = L::add(sum3, L::mul(h, L::load(x + k + 3 * L::width)));
+        }
+
+        L::store(output + n, sum0);
+        L::store(output + n + L::width, sum1);
+        L::store(output + n + 2 * L::width, sum2);
+        L::store(output + n + 3 * L::width, sum3);
+    }
+
+    for (; n + L::width <= numSamples; n += L::width)
+    {
+        const float* x = input + n;
+        Vec sum = L::set1(0.0);
+
+        for (int k = 0; k < numTaps; ++k)
+        {
+            sum = L::add(sum, L::mul(L::set1(reversedCoefficients[k]), L::load(x + k)));
+        }
+        L::store(output + n, sum);
+    }
+    return n;
+}
+
+//==============================================================================
+HRTFConvolver::HRTFConvolver()
+{
+    maximumBlockSize_ = 0;
+    numTaps_ = HRIR_SIZE;
+    currentFilter_ = 0;
+    hasFilter_ = false;
+    crossfadeLength_ = 1;
+    crossfadePosition_ = 1;
+}
+
+/*
+  * @brief Allocate the input history and crossfade buffers. Must be called before process, and not on the audio thread
+  * @param Largest number of samples that will be processed at once
+  * @param Number of samples over which the outgoing and incoming filters are crossfaded
+  * @param Number of taps from the start of each HRIR to convolve with, up to HRIR_SIZE
+*/
+void HRTFConvolver::prepare(int maximumBlockSize, int crossfadeLength, int numTaps)
+{
+    maximumBlockSize_ = jmax(1, maximumBlockSize);
+    crossfadeLength_ = jmax(1, crossfadeLength);
+    numTaps = jlimit(1, HRIR_SIZE, numTaps);
+
+    // A filter loaded for a different number of taps no longer lines up with the history
+    if (numTaps != numTaps_)
+    {
+        numTaps_ = numTaps;
+        hasFilter_ = false;
+    }
+
+    history_.setSize(HRIR_NUM_EARS, numTaps_ - 1 + maximumBlockSize_);
+    crossfadeBuffer_.setSize(HRIR_NUM_EARS, maximumBlockSize_);
+
+    reset();
+}
+
+/*
+  * @brief Clear the input history and finish any crossfade in progress
+*/
+void HRTFConvolver::reset()
+{
+    history_.clear();
+    crossfadeBuffer_.clear();
+    crossfadePosition_ = crossfadeLength_;
+}
+
+/*
+  * @brief Start crossfading to a new filter. Copies the coefficients, so the filter does not need to outlive this call. Does not allocate
+  * @param Per-ear filter to switch to
+*/
+void HRTFConvolver::loadFilter(const HRTFFilter& filter)
+{
+    // The first filter is loaded straight into place; after that the incoming filter goes into the idle slot and is faded in
+    const int targetFilter = hasFilter_ ? 1 - currentFilter_ : currentFilter_;
+
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        for (int i = 0; i < numTaps_; ++i)
+        {
+            coefficients_[targetFilter][ear][i] = filter.coefficients[ear][numTaps_ - 1 - i];
+        }
+    }
+
+    crossfadePosition_ = hasFilter_ ? 0 : crossfadeLength_;
+    currentFilter_ = targetFilter;
+    hasFilter_ = true;
+}
+
+/*
+  * @brief Whether the previous filter is still being faded out. A new filter should only be loaded once this returns false
+*/
+bool HRTFConvolver::isCrossfading() const
+{
+    return crossfadePosition_ < crossfadeLength_;
+}
+
+/*
+  * @brief Convolve each channel of the buffer in place with its ear's filter
+  * @param Buffer with one channel per ear
+  * @param Number of samples to process
+*/
+void HRTFConvolver::process(AudioSampleBuffer& buffer, int numSamples)
+{
+    const int numChannels = jmin(buffer.getNumChannels(), HRIR_NUM_EARS);
+
+    if (! hasFilter_)
+        return;
+
+    for (int start = 0; start < numSamples; start += maximumBlockSize_)
+    {
+        const int blockSize = jmin(maximumBlockSize_, numSamples - start);
+        // Gain of the incoming filter at the start of this block
+        const int fadeStart = crossfadePosition_;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* channelData = buffer.getWritePointer(channel, start);
+            float* historyData = history_.getWritePointer(channel);
+
+            // Append the new input after the retained history, then convolve from the start of the history
+            FloatVectorOperations::copy(historyData + numTaps_ - 1, channelData, blockSize);
+            convolve(historyData, coefficients_[currentFilter_][channel], channelData, blockSize);
+
+            // During a crossfade run the outgoing filter over the same input and mix the two outputs with a linear ramp
+            if (fadeStart < crossfadeLength_)
+            {
+                float* crossfadeData = crossfadeBuffer_.getWritePointer(channel);
+                convolve(historyData, coefficients_[1 - currentFilter_][channel], crossfadeData, blockSize);
+
+                int position = fadeStart;
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    const float incomingGain = position < crossfadeLength_ ? (float)position / (float)crossfadeLength_ : 1.0f;
+                    channelData[i] = incomingGain * channelData[i] + (1.0f - incomingGain) * crossfadeData[i];
+                    ++position;
+                }
+            }
+
+            // Keep the last numTaps_ - 1 input samples for the next block
+            std::memmove(historyData, historyData + blockSize, (numTaps_ - 1) * sizeof(float));
+        }
+
+        crossfadePosition_ = jmin(crossfadeLength_, fadeStart + blockSize);
+    }
+}
+
+/*
+  * @brief Direct-form FIR: each output sample is the dot product of the time-reversed filter with the most recent numTaps_ inputs, worked out for as many output
+  * samples per instruction as the native lanes hold
+  * @param Input history, where input[numTaps_ - 1 + n] is the n-th new sample
+  * @param Time-reversed coefficients
+  * @param Output array
+  * @param Number of output samples
+*/
+void HRTFConvolver::convolve(const float* input, const float* reversedCoefficients, float* output, int numSamples) const
+{
+    const int n = firLanes<NativeFloatLanes>(input, reversedCoefficients, numTaps_, output, 0, numSamples);
+    firLanes<TailFloatLanes>(input, reversedCoefficients, numTaps_, output, n, numSamples);
+}
+
+/*
+  * @brief Delay added by the convolver, in samples. Each output sample only needs inputs that have already arrived, so there is none
+*/
+int HRTFConvolver::getLatencySamples() const
+{
+    return 0;
+}
+
+HRTFConvolver::~HRTFConvolver()
+{
+
+}
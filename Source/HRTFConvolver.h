@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRBank.h"
+#include "HRTFFilterSwap.h"
+
+class HRTFConvolver
+{
+public:
+    HRTFConvolver();
+    ~HRTFConvolver();
+
+    void prepare(int maximumBlockSize, int crossfadeLength, int numTaps = HRIR_SIZE);
+    void reset();
+    void loadFilter(const HRTFFilter& filter);
+    void process(AudioSampleBuffer& buffer, int numSamples);
+    bool isCrossfading() const;
+    int getLatencySamples() const;
+
+private:
+    void convolve(const float* input, const float* reversedCoefficients, float* output, int numSamples) const;
+
+    // Number of taps from the start of each HRIR that are convolved, so the convolver can also serve as the head of a longer filter
+    int numTaps_;
+    // Each ear's input, preceded by the last numTaps_ - 1 samples of the previous block
+    AudioSampleBuffer history_;
+    // Output of the outgoing filter while a crossfade is in progress
+    AudioSampleBuffer crossfadeBuffer_;
+    int maximumBlockSize_;
+
+    // Two filter slots, coefficients stored time-reversed so each output sample is a forward dot product
+    float coefficients_[2][HRIR_NUM_EARS][HRIR_SIZE];
+    int currentFilter_;
+    bool hasFilter_;
+
+    int crossfadeLength_;
+    int crossfadePosition_;
+
+    JUCE_DECLARE_NON_COPYABLE (HRTFConvolver)
+};
@@ -0,0 +1,156 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFConvolverSelector.h"
+
+/*
+  * @brief Time a convolver steadily filtering blocks of noise, after one run to warm the caches
+  * @param Convolver, prepared and loaded with a filter
+  * @param Block of noise, one channel per ear
+  * @param Buffer the noise is copied into and filtered in place, so the level never builds up or dies away from one block to the next
+  * @param Block size
+  * @return Seconds taken by the fastest trial
+*/
+template <typename Convolver>
+static double timeConvolver(Convolver& convolver, const AudioSampleBuffer& noise, AudioSampleBuffer& buffer, int blockSize)
+{
+    const int numBlocks = jmax(1, HRTF_SELECTOR_TRIAL_SAMPLES / blockSize);
+    double fastest = 0.0;
+
+    for (int trial = 0; trial <= HRTF_SELECTOR_NUM_TRIALS; ++trial)
+    {
+        const int64 start = Time::getHighResolutionTicks();
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int channel = 0; channel < HRIR_NUM_EARS; ++channel)
+            {
+                FloatVectorOperations::copy(buffer.getWritePointer(channel), noise.getReadPointer(channel), blockSize);
+            }
+            convolver.process(buffer, blockSize);
+        }
+        const double seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+
+        // Trial 0 is the warm-up
+        if (trial == 1 || (trial > 1 && seconds < fastest))
+            fastest = seconds;
+    }
+    return fastest;
+}
+
+/*
+  * @brief Resolve a convolver mode into the convolver to use at a block size
+  * @param automaticConvolver, directConvolver, partitionedConvolver or hybridConvolver
+  * @param Host block size
+  * @return directConvolver, partitionedConvolver or hybridConvolver
+*/
+int HRTFConvolverSelector::choose(int mode, int blockSize)
+{
+    if (mode == directConvolver || mode == partitionedConvolver || mode == hybridConvolver)
+        return mode;
+
+    return choose(blockSize);
+}
+
+/*
+  * @brief Choose between the direct FIR, the partitioned FFT and the hybrid convolver for a block size by timing them on this machine. The direct FIR does the least
+  * bookkeeping on short blocks, while the FFT's cost per sample falls as the partitions grow. Only convolvers that need no latency are timed, so whichever wins, the
+  * latency reported to the host is the same: the partitioned FFT takes part only when the block is whole partitions. Each block size is only timed the first time
+  * it is asked for, and every later call (from any instance of the plugin) returns the same choice. Allocates and creates FFTW plans, so must not be called on the
+  * audio thread
+  * @param Host block size
+  * @return directConvolver, partitionedConvolver or hybridConvolver
+*/
+int HRTFConvolverSelector::choose(int blockSize)
+{
+    blockSize = jmax(1, blockSize);
+
+    // Below the smallest partition the FFT convolver would transform more than a block at a time, and still add its latency
+    if (blockSize < HRTF_PARTITION_MIN_SIZE)
+        return directConvolver;
+
+    // Held while timing too, so two instances preparing at once neither time the same block size twice nor slow each other's trials down
+    static CriticalSection selectorLock;
+    static Array<int> timedBlockSizes;
+    static Array<int> timedChoices;
+    const ScopedLock lock (selectorLock);
+
+    const int index = timedBlockSizes.indexOf(blockSize);
+    if (index >= 0)
+        return timedChoices.getUnchecked(index);
+
+    const int choice = timeConvolvers(blockSize);
+    timedBlockSizes.add(blockSize);
+    timedChoices.add(choice);
+    return choice;
+}
+
+/*
+  * @brief Time the convolvers that need no latency at a block size and pick the quickest
+  * @param Host block size, at least HRTF_PARTITION_MIN_SIZE
+  * @return directConvolver, partitionedConvolver or hybridConvolver
+*/
+int HRTFConvolverSelector::timeConvolvers(int blockSize)
+{
+    // A decaying noise filter and a block of noise, so the timing depends on nothing but the block size
+    Random random (1);
+    HRTFFilter filter;
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        for (int i = 0; i < HRIR_SIZE; ++i)
+        {
+            filter.coefficients[ear][i] = (random.nextFloat() * 2.0f - 1.0f) * std::exp(-i / 32.0f);
+        }
+    }
+
+    AudioSampleBuffer noise (HRIR_NUM_EARS, blockSize), buffer (HRIR_NUM_EARS, blockSize);
+    for (int channel = 0; channel < HRIR_NUM_EARS; ++channel)
+    {
+        for (int i = 0; i < blockSize; ++i)
+        {
+            noise.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+        }
+    }
+
+    // A crossfade length of 1 sample, so neither convolver spends the trials crossfading
+    HRTFConvolver direct;
+    direct.prepare(blockSize, 1);
+    direct.loadFilter(filter);
+
+    HRTFHybridConvolver hybrid;
+    hybrid.prepare(blockSize, 1);
+    hybrid.loadFilter(filter);
+
+    // Keep the quickest. Once the head covers the whole HRIR the hybrid is just the direct FIR
+    int choice = directConvolver;
+    double fastestSeconds = timeConvolver(direct, noise, buffer, blockSize);
+
+    if (hybrid.getNumStages() > 0)
+    {
+        const double hybridSeconds = timeConvolver(hybrid, noise, buffer, blockSize);
+        if (hybridSeconds < fastestSeconds)
+        {
+            choice = hybridConvolver;
+            fastestSeconds = hybridSeconds;
+        }
+    }
+
+    // Otherwise the FFT convolver would add a partition of latency, and the timing would decide what the host is told
+    HRTFPartitionedConvolver partitioned;
+    partitioned.prepare(blockSize, 1);
+
+    if (partitioned.getLatencySamples() == 0)
+    {
+        partitioned.loadFilter(filter);
+        if (timeConvolver(partitioned, noise, buffer, blockSize) < fastestSeconds)
+            choice = partitionedConvolver;
+    }
+
+    return choice;
+}
@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HRTFConvolver.h"
+#include "HRTFPartitionedConvolver.h"
+#include "HRTFHybridConvolver.h"
+
+// Number of timed runs of each convolver, of which the fastest counts, and the least audio each run covers
+#define HRTF_SELECTOR_NUM_TRIALS 7
+#define HRTF_SELECTOR_TRIAL_SAMPLES 16384
+
+class HRTFConvolverSelector
+{
+public:
+    enum Mode
+    {
+        automaticConvolver = 0,
+        directConvolver,
+        partitionedConvolver,
+        hybridConvolver
+    };
+
+    static int choose(int mode, int blockSize);
+    static int choose(int blockSize);
+
+private:
+    static int timeConvolvers(int blockSize);
+};
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFDenseGrid.h"
+
+HRTFDenseGrid::HRTFDenseGrid()
+    : Thread ("HRTF dense grid")
+{
+    ready_ = false;
+    irBank_ = nullptr;
+    hrirGrid_ = nullptr;
+}
+
+/*
+  * @brief Start synthesising the grid on a background thread, unless it is already built or being built. Call from the message thread
+  * @param The bank holding the HRIRs, already built. Must not be rebuilt while the grid is being built
+  * @param The index over the bank, already built
+*/
+void HRTFDenseGrid::startBuilding(const IRBank& irBank, const HRIRGrid& hrirGrid)
+{
+    if (ready_.load() || isThreadRunning() || hrirGrid.isBuilt() == false)
+        return;
+
+    irBank_ = &irBank;
+    hrirGrid_ = &hrirGrid;
+
+    // Allocated here rather than on the background thread, so any failure shows up on the caller's
+    if (filters_ == nullptr)
+        filters_.malloc((size_t)(HRTF_DENSE_GRID_NUM_ELEVATIONS * HRTF_DENSE_GRID_NUM_AZIMUTHS));
+
+    // Low priority, as the blend in updateHRTF covers for the grid until it is ready
+    startThread(2);
+}
+
+/*
+  * @brief Stop the background thread if it is still building. The grid stays unready and is built again on the next call to startBuilding
+*/
+void HRTFDenseGrid::stopBuilding()
+{
+    stopThread(4000);
+}
+
+/*
+  * @brief Stop building and free the grid, which becomes unready until it is built again. Must not be called while another thread may be reading a filter from it
+*/
+void HRTFDenseGrid::release()
+{
+    stopBuilding();
+    ready_.store(false);
+    filters_.free();
+}
+
+/*
+  * @brief Whether every filter in the grid has been synthesised
+*/
+bool HRTFDenseGrid::isReady() const
+{
+    return ready_.load();
+}
+
+/*
+  * @brief Return the filter at the grid point nearest a direction. Only valid once isReady returns true. Does not allocate or lock
+  * @param Azimuth in radians, between -π and π as sent by the GUI
+  * @param Elevation in degrees
+*/
+const HRTFFilter& HRTFDenseGrid::getFilter(double azimuth, double elevation) const
+{
+    jassert(isReady());
+
+    // Round to the nearest grid point, wrapping the azimuth round to 0-360° and limiting the elevation to ±90°
+    const int column = ((int)std::lround(rad2deg(azimuth) / HRTF_DENSE_GRID_AZIMUTH_STEP) % HRTF_DENSE_GRID_NUM_AZIMUTHS + HRTF_DENSE_GRID_NUM_AZIMUTHS) % HRTF_DENSE_GRID_NUM_AZIMUTHS;
+    const int row = jlimit(0, HRTF_DENSE_GRID_NUM_ELEVATIONS - 1, (int)std::lround((elevation + 90.0) / HRTF_DENSE_GRID_ELEVATION_STEP));
+
+    return filters_[row * HRTF_DENSE_GRID_NUM_AZIMUTHS + column];
+}
+
+/*
+  * @brief Background thread: synthesise the filter for every grid point with the same blend updateHRTF uses, then mark the grid ready
+*/
+void HRTFDenseGrid::run()
+{
+    for (int row = 0; row < HRTF_DENSE_GRID_NUM_ELEVATIONS; ++row)
+    {
+        const double elevation = -90.0 + row * HRTF_DENSE_GRID_ELEVATION_STEP;
+
+        for (int column = 0; column < HRTF_DENSE_GRID_NUM_AZIMUTHS; ++column)
+        {
+            if (threadShouldExit())
+                return;
+
+            const double azimuth = deg2rad((double)(column * HRTF_DENSE_GRID_AZIMUTH_STEP));
+            impulseResponseCrossfade_.synthesise(*irBank_, hrirGrid_->lookup(azimuth, elevation), filters_[row * HRTF_DENSE_GRID_NUM_AZIMUTHS + column]);
+        }
+    }
+
+    // Publishes the filters written above to whichever thread next sees the grid as ready
+    ready_.store(true);
+}
+
+HRTFDenseGrid::~HRTFDenseGrid()
+{
+    stopBuilding();
+}
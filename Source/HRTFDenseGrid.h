@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include "IRBank.h"
+#include "HRIRGrid.h"
+#include "IRCrossfade.h"
+#include "HRTFFilterSwap.h"
+
+// Spacing of the dense grid in degrees. At 2° by 5° it holds 180 x 37 filters of 2 x HRIR_SIZE floats, about 13.6 MB
+#define HRTF_DENSE_GRID_AZIMUTH_STEP 2
+#define HRTF_DENSE_GRID_ELEVATION_STEP 5
+#define HRTF_DENSE_GRID_NUM_AZIMUTHS (360 / HRTF_DENSE_GRID_AZIMUTH_STEP)
+#define HRTF_DENSE_GRID_NUM_ELEVATIONS (180 / HRTF_DENSE_GRID_ELEVATION_STEP + 1)
+
+// Ready-to-use HRTFs synthesised for every point of a dense azimuth/elevation grid on a background thread, so that once it is built a source position
+// is turned into a filter by a single indexed load instead of a blend
+class HRTFDenseGrid  : private Thread
+{
+public:
+    HRTFDenseGrid();
+    ~HRTFDenseGrid();
+
+    void startBuilding(const IRBank& irBank, const HRIRGrid& hrirGrid);
+    void stopBuilding();
+    void release();
+    bool isReady() const;
+    const HRTFFilter& getFilter(double azimuth, double elevation) const;
+
+private:
+    void run() override;
+
+    // Filters laid out as [elevation][azimuth], from -90° and 0° respectively
+    HeapBlock<HRTFFilter> filters_;
+    std::atomic<bool> ready_;
+
+    // Only read by the background thread, and only while it runs
+    const IRBank* irBank_;
+    const HRIRGrid* hrirGrid_;
+    IRCrossfade impulseResponseCrossfade_;
+
+    JUCE_DECLARE_NON_COPYABLE (HRTFDenseGrid)
+};
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFFilterCache.h"
+
+// Quantised azimuths take up to 360/HRTF_FILTER_CACHE_RESOLUTION values, so the elevation is packed into the key above them
+#define HRTF_FILTER_CACHE_AZIMUTH_STEPS ((int)(360.0 / HRTF_FILTER_CACHE_RESOLUTION))
+
+HRTFFilterCache::HRTFFilterCache()
+{
+    clear();
+    resetCounters();
+}
+
+/*
+  * @brief Round a direction to the nearest point of the cache's grid. Filters should be synthesised for the rounded direction, so that an entry does not depend on
+  * which position inside its cell happened to be seen first
+  * @param Azimuth in radians, between -π and π as sent by the GUI, rounded in place
+  * @param Elevation in degrees, rounded in place
+*/
+void HRTFFilterCache::quantise(double& azimuth, double& elevation)
+{
+    azimuth = deg2rad(std::round(rad2deg(azimuth) / HRTF_FILTER_CACHE_RESOLUTION) * HRTF_FILTER_CACHE_RESOLUTION);
+    elevation = std::round(elevation / HRTF_FILTER_CACHE_RESOLUTION) * HRTF_FILTER_CACHE_RESOLUTION;
+}
+
+int HRTFFilterCache::makeKey(double azimuth, double elevation)
+{
+    const int azimuthStep = ((int)std::lround(rad2deg(azimuth) / HRTF_FILTER_CACHE_RESOLUTION) % HRTF_FILTER_CACHE_AZIMUTH_STEPS + HRTF_FILTER_CACHE_AZIMUTH_STEPS) % HRTF_FILTER_CACHE_AZIMUTH_STEPS;
+    const int elevationStep = (int)std::lround((jlimit(-90.0, 90.0, elevation) + 90.0) / HRTF_FILTER_CACHE_RESOLUTION);
+    return elevationStep * HRTF_FILTER_CACHE_AZIMUTH_STEPS + azimuthStep;
+}
+
+/*
+  * @brief Look up the filter for a direction, counting a hit or a miss. A hit becomes the most recently used entry
+  * @param Azimuth in radians
+  * @param Elevation in degrees
+  * @return The cached filter, or nullptr if there is none for the direction's cell
+*/
+const HRTFFilter* HRTFFilterCache::find(double azimuth, double elevation)
+{
+    const int key = makeKey(azimuth, elevation);
+
+    for (int entry = head_; entry >= 0; entry = next_[entry])
+    {
+        if (keys_[entry] == key)
+        {
+            moveToFront(entry);
+            ++hitCount_;
+            return &filters_[entry];
+        }
+    }
+
+    ++missCount_;
+    return nullptr;
+}
+
+/*
+  * @brief Claim the entry for a direction, evicting the least recently used one if the cache is full. The caller fills in the returned filter
+  * @param Azimuth in radians
+  * @param Elevation in degrees
+  * @return The filter to synthesise into, now the most recently used entry
+*/
+HRTFFilter& HRTFFilterCache::insert(double azimuth, double elevation)
+{
+    const int key = makeKey(azimuth, elevation);
+
+    // Reuse the direction's own entry if it has one, then any unused entry, and otherwise the least recently used
+    int entry = -1;
+    for (int i = 0; i < HRTF_FILTER_CACHE_CAPACITY && entry < 0; ++i)
+    {
+        if (keys_[i] == key)
+            entry = i;
+    }
+    for (int i = 0; i < HRTF_FILTER_CACHE_CAPACITY && entry < 0; ++i)
+    {
+        if (keys_[i] < 0)
+            entry = i;
+    }
+    if (entry < 0)
+        entry = tail_;
+
+    keys_[entry] = key;
+    moveToFront(entry);
+    return filters_[entry];
+}
+
+/*
+  * @brief Drop every entry (e.g. once the HRIRs the filters were synthesised from have changed)
+*/
+void HRTFFilterCache::clear()
+{
+    for (int entry = 0; entry < HRTF_FILTER_CACHE_CAPACITY; ++entry)
+    {
+        keys_[entry] = -1;
+        previous_[entry] = -1;
+        next_[entry] = -1;
+    }
+    head_ = -1;
+    tail_ = -1;
+}
+
+/*
+  * @brief Take an entry out of the usage list, if it is in it
+*/
+void HRTFFilterCache::unlink(int entry)
+{
+    if (previous_[entry] >= 0)
+        next_[previous_[entry]] = next_[entry];
+    else if (head_ == entry)
+        head_ = next_[entry];
+
+    if (next_[entry] >= 0)
+        previous_[next_[entry]] = previous_[entry];
+    else if (tail_ == entry)
+        tail_ = previous_[entry];
+
+    previous_[entry] = -1;
+    next_[entry] = -1;
+}
+
+/*
+  * @brief Make an entry the most recently used
+*/
+void HRTFFilterCache::moveToFront(int entry)
+{
+    if (head_ == entry)
+        return;
+
+    unlink(entry);
+
+    next_[entry] = head_;
+    if (head_ >= 0)
+        previous_[head_] = entry;
+    head_ = entry;
+
+    if (tail_ < 0)
+        tail_ = entry;
+}
+
+int HRTFFilterCache::getHitCount() const
+{
+    return hitCount_;
+}
+
+int HRTFFilterCache::getMissCount() const
+{
+    return missCount_;
+}
+
+void HRTFFilterCache::resetCounters()
+{
+    hitCount_ = 0;
+    missCount_ = 0;
+}
+
+HRTFFilterCache::~HRTFFilterCache()
+{
+}
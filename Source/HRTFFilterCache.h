@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HRTFFilterSwap.h"
+#include "Util.h"
+
+// Number of filters kept, each 2 x HRIR_SIZE floats (2 KB), and the step in degrees directions are quantised to before they are used as keys
+#define HRTF_FILTER_CACHE_CAPACITY 64
+#define HRTF_FILTER_CACHE_RESOLUTION 1.0
+
+// Fixed-capacity, least recently used cache of synthesised HRTFs, keyed by quantised direction. All storage is allocated up front, so neither a hit nor a miss allocates
+class HRTFFilterCache
+{
+public:
+    HRTFFilterCache();
+    ~HRTFFilterCache();
+
+    static void quantise(double& azimuth, double& elevation);
+
+    const HRTFFilter* find(double azimuth, double elevation);
+    HRTFFilter& insert(double azimuth, double elevation);
+    void clear();
+
+    int getHitCount() const;
+    int getMissCount() const;
+    void resetCounters();
+
+private:
+    static int makeKey(double azimuth, double elevation);
+    void moveToFront(int entry);
+    void unlink(int entry);
+
+    HRTFFilter filters_[HRTF_FILTER_CACHE_CAPACITY];
+    int keys_[HRTF_FILTER_CACHE_CAPACITY];
+
+    // Entries in order of use, as a doubly linked list of indices from the most (head_) to the least (tail_) recently used. Unused entries have a key of -1
+    int previous_[HRTF_FILTER_CACHE_CAPACITY];
+    int next_[HRTF_FILTER_CACHE_CAPACITY];
+    int head_;
+    int tail_;
+
+    int hitCount_;
+    int missCount_;
+
+    JUCE_DECLARE_NON_COPYABLE (HRTFFilterCache)
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFFilterSwap.h"
+
+// The low bits of shared_ hold a slot index, and this bit marks it as published but not yet picked up by the consumer
+static const int freshFilterFlag = 4;
+static const int filterIndexMask = 3;
+
+/*
+  * @brief Copy a 2-channel impulse response into the filter, optionally normalising it the way juce::dsp::Convolution does on load
+  * @param Impulse response with one channel per ear
+  * @param Whether to scale the impulse response so the louder ear has an energy of 1/64
+*/
+void HRTFFilter::copyFrom(const AudioSampleBuffer& impulse, bool normalise)
+{
+    const int numSamples = jmin(impulse.getNumSamples(), HRIR_SIZE);
+    float maxEnergy = 0.0f;
+
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        const float* impulseData = impulse.getReadPointer(jmin(ear, impulse.getNumChannels() - 1));
+        float energy = 0.0f;
+
+        for (int i = 0; i < HRIR_SIZE; ++i)
+        {
+            coefficients[ear][i] = i < numSamples ? impulseData[i] : 0.0f;
+            energy += coefficients[ear][i] * coefficients[ear][i];
+        }
+        maxEnergy = jmax(maxEnergy, energy);
+    }
+
+    if (normalise && maxEnergy > 0.0f)
+    {
+        const float normalisationFactor = 0.125f / std::sqrt(maxEnergy);
+
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        {
+            for (int i = 0; i < HRIR_SIZE; ++i)
+            {
+                coefficients[ear][i] *= normalisationFactor;
+            }
+        }
+    }
+}
+
+HRTFFilterSwap::HRTFFilterSwap()
+{
+    writeIndex_ = 0;
+    shared_ = 1;
+    readIndex_ = 2;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        std::fill(&filters_[i].coefficients[0][0], &filters_[i].coefficients[0][0] + HRIR_NUM_EARS * HRIR_SIZE, 0.0f);
+    }
+}
+
+/*
+  * @brief Return the slot the producer may fill before calling publish. Never read by the consumer until published
+*/
+HRTFFilter& HRTFFilterSwap::getWriteFilter()
+{
+    return filters_[writeIndex_];
+}
+
+/*
+  * @brief Hand the filter written through getWriteFilter to the consumer, replacing any filter it has not picked up yet
+*/
+void HRTFFilterSwap::publish()
+{
+    writeIndex_ = shared_.exchange(writeIndex_ | freshFilterFlag, std::memory_order_acq_rel) & filterIndexMask;
+}
+
+/*
+  * @brief Wait-free check for a newly published filter, safe to call on the audio thread
+  * @return The most recently published filter if it has not been acquired before, otherwise nullptr. It stays valid until the next call that returns non-null
+*/
+const HRTFFilter* HRTFFilterSwap::acquire()
+{
+    if ((shared_.load(std::memory_order_relaxed) & freshFilterFlag) == 0)
+        return nullptr;
+
+    readIndex_ = shared_.exchange(readIndex_, std::memory_order_acq_rel) & filterIndexMask;
+    return &filters_[readIndex_];
+}
+
+HRTFFilterSwap::~HRTFFilterSwap()
+{
+
+}
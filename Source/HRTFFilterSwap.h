@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include "IRBank.h"
+
+// Time over which a filter consumer crossfades from the outgoing to the incoming HRTF
+#define HRTF_CROSSFADE_SECONDS 0.02
+
+struct HRTFFilter
+{
+    void copyFrom(const AudioSampleBuffer& impulse, bool normalise);
+
+    // Per-ear FIR coefficients (0 = left, 1 = right)
+    float coefficients[HRIR_NUM_EARS][HRIR_SIZE];
+};
+
+class HRTFFilterSwap
+{
+public:
+    HRTFFilterSwap();
+    ~HRTFFilterSwap();
+
+    // Producer side (the thread that synthesises filters)
+    HRTFFilter& getWriteFilter();
+    void publish();
+
+    // Consumer side (the audio thread)
+    const HRTFFilter* acquire();
+
+private:
+    // Triple buffer: the producer and consumer each own one slot, and the third is handed between them through shared_
+    HRTFFilter filters_[3];
+    std::atomic<int> shared_;
+    int writeIndex_;
+    int readIndex_;
+
+    JUCE_DECLARE_NON_COPYABLE (HRTFFilterSwap)
+};
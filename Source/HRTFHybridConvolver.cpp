@@ -0,0 +1,187 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFHybridConvolver.h"
+
+HRTFHybridConvolver::HRTFHybridConvolver()
+{
+    headSize_ = HRIR_SIZE;
+    numStages_ = 0;
+    maximumBlockSize_ = 0;
+    hasFilter_ = false;
+}
+
+/*
+  * @brief Size the head from the host block size and lay out the FFT stages behind it. Must be called before process, and not on the audio thread
+  * @param Largest number of samples that will be processed at once
+  * @param Number of samples over which the outgoing and incoming filters are crossfaded
+*/
+void HRTFHybridConvolver::prepare(int maximumBlockSize, int crossfadeLength)
+{
+    maximumBlockSize_ = jmax(1, maximumBlockSize);
+
+    // The direct head costs B multiplies per sample for a head of B taps, so it is kept to about one block. Past half the HRIR the head simply covers all of it
+    headSize_ = jlimit(HRTF_PARTITION_MIN_SIZE, HRIR_SIZE, nextPowerOf2(maximumBlockSize_));
+    if (headSize_ > HRIR_SIZE/2)
+        headSize_ = HRIR_SIZE;
+
+    head_.prepare(maximumBlockSize_, crossfadeLength, headSize_);
+
+    numStages_ = 0;
+    for (int partitionSize = headSize_; partitionSize < HRIR_SIZE; partitionSize *= 2)
+    {
+        stages_[numStages_++].prepareSegment(partitionSize, partitionSize, partitionSize, crossfadeLength);
+    }
+    for (int stage = numStages_; stage < HRTF_HYBRID_MAX_STAGES; ++stage)
+    {
+        stages_[stage].release();
+    }
+
+    input_.setSize(HRIR_NUM_EARS, maximumBlockSize_);
+    stageOutput_.setSize(HRIR_NUM_EARS, maximumBlockSize_);
+
+    // The head and stages each forget a filter loaded for a different layout
+    hasFilter_ = false;
+    reset();
+}
+
+/*
+  * @brief Free the stages' delay lines and plans
+*/
+void HRTFHybridConvolver::release()
+{
+    for (int stage = 0; stage < HRTF_HYBRID_MAX_STAGES; ++stage)
+    {
+        stages_[stage].release();
+    }
+    numStages_ = 0;
+    hasFilter_ = false;
+}
+
+/*
+  * @brief Clear the input history of the head and every stage, and finish any crossfade in progress
+*/
+void HRTFHybridConvolver::reset()
+{
+    head_.reset();
+
+    for (int stage = 0; stage < numStages_; ++stage)
+    {
+        stages_[stage].reset();
+    }
+}
+
+/*
+  * @brief Start crossfading the head and every stage to a new filter together. Does not allocate
+  * @param Per-ear filter to switch to
+*/
+void HRTFHybridConvolver::loadFilter(const HRTFFilter& filter)
+{
+    head_.loadFilter(filter);
+
+    for (int stage = 0; stage < numStages_; ++stage)
+    {
+        stages_[stage].loadFilter(filter);
+    }
+    hasFilter_ = true;
+}
+
+/*
+  * @brief Whether the head or any stage is still fading out the previous filter. A stage only starts its crossfade at its next partition, so a new filter should
+  * only be loaded once this returns false
+*/
+bool HRTFHybridConvolver::isCrossfading() const
+{
+    bool crossfading = head_.isCrossfading();
+
+    for (int stage = 0; stage < numStages_; ++stage)
+    {
+        crossfading = crossfading || stages_[stage].isCrossfading();
+    }
+    return crossfading;
+}
+
+/*
+  * @brief Convolve each channel of the buffer in place with its ear's filter, without delaying it
+  * @param Buffer with one channel per ear
+  * @param Number of samples to process
+*/
+void HRTFHybridConvolver::process(AudioSampleBuffer& buffer, int numSamples)
+{
+    const int numChannels = jmin(buffer.getNumChannels(), HRIR_NUM_EARS);
+
+    // Without a filter the head and each stage would pass the input straight through, and add up to several copies of it
+    if (! hasFilter_)
+        return;
+
+    for (int start = 0; start < numSamples; start += maximumBlockSize_)
+    {
+        const int blockSize = jmin(maximumBlockSize_, numSamples - start);
+
+        // Keep the input for the stages, and run the head over a copy of it, written back as the start of the output
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            input_.copyFrom(channel, 0, buffer, channel, start, blockSize);
+            stageOutput_.copyFrom(channel, 0, buffer, channel, start, blockSize);
+        }
+
+        head_.process(stageOutput_, blockSize);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            buffer.copyFrom(channel, start, stageOutput_, channel, 0, blockSize);
+        }
+
+        // Each stage then filters its own copy of the input, which is added to the head's output
+        for (int stage = 0; stage < numStages_; ++stage)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                stageOutput_.copyFrom(channel, 0, input_, channel, 0, blockSize);
+            }
+
+            stages_[stage].process(stageOutput_, blockSize);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                buffer.addFrom(channel, start, stageOutput_, channel, 0, blockSize);
+            }
+        }
+    }
+}
+
+/*
+  * @brief Number of taps convolved directly, chosen from the host block size in prepare
+*/
+int HRTFHybridConvolver::getHeadSize() const
+{
+    return headSize_;
+}
+
+/*
+  * @brief Number of FFT stages behind the head
+*/
+int HRTFHybridConvolver::getNumStages() const
+{
+    return numStages_;
+}
+
+/*
+  * @brief Delay added by the convolver, in samples. The head needs no latency and every stage's latency is covered by its offset into the HRIR, so there is none
+*/
+int HRTFHybridConvolver::getLatencySamples() const
+{
+    return 0;
+}
+
+HRTFHybridConvolver::~HRTFHybridConvolver()
+{
+    release();
+}
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRBank.h"
+#include "HRTFFilterSwap.h"
+#include "HRTFConvolver.h"
+#include "HRTFPartitionedConvolver.h"
+
+// With the smallest head, the FFT stages double in size from HRTF_PARTITION_MIN_SIZE up to half the HRIR
+#define HRTF_HYBRID_MAX_STAGES 3
+
+class HRTFHybridConvolver
+{
+public:
+    HRTFHybridConvolver();
+    ~HRTFHybridConvolver();
+
+    void prepare(int maximumBlockSize, int crossfadeLength);
+    void release();
+    void reset();
+    void loadFilter(const HRTFFilter& filter);
+    void process(AudioSampleBuffer& buffer, int numSamples);
+    bool isCrossfading() const;
+    int getHeadSize() const;
+    int getNumStages() const;
+    int getLatencySamples() const;
+
+private:
+    // Gardner's non-uniform layout: the head (the first B taps) is convolved directly, and then stage s, with partitions of 2^s B samples, covers taps [2^s B, 2^(s+1) B).
+    // Each stage's one-partition latency is exactly the offset of its first tap, so the stages add up to the whole HRIR with no latency at all
+    HRTFConvolver head_;
+    HRTFPartitionedConvolver stages_[HRTF_HYBRID_MAX_STAGES];
+    int headSize_;
+    int numStages_;
+    int maximumBlockSize_;
+    bool hasFilter_;
+
+    // Copy of the input for each stage to filter, and the stage's output while it is summed in
+    AudioSampleBuffer input_;
+    AudioSampleBuffer stageOutput_;
+
+    JUCE_DECLARE_NON_COPYABLE (HRTFHybridConvolver)
+};
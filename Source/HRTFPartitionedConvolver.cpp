@@ -0,0 +1,543 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFPartitionedConvolver.h"
+#include "SpectralLanes.h"
+
+/*
+  * @brief Multiply-accumulate bins [start, end) in lanes: output[k] = Σ_p X[p][k] H[p][k], over split real/imaginary spectra
+  * @return First bin not processed, as only whole vectors are
+*/
+template <typename L>
+static int multiplyAccumulateLanes(const SpectralSample* const* inputSpectra, const SpectralSample* const* filterSpectra, int numPartitions, int binStride,
+                                   int start, int end, SpectralComplex* output)
+{
+    typedef typename L::Vec Vec;
+
+    int i = start;
+    for (; i + L::width <= end; i += L::width)
+    {
+        Vec sumRe = L::set1(0.0);
+        Vec sumIm = L::set1(0.0);
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            const Vec xRe = L::load(inputSpectra[p] + i);
+            const Vec xIm = L::load(inputSpectra[p] + binStride + i);
+            const Vec hRe = L::load(filterSpectra[p] + i);
+            const Vec hIm = L::load(filterSpectra[p] + binStride + i);
+
+            sumRe = L::add(sumRe, L::sub(L::mul(xRe, hRe), L::mul(xIm, hIm)));
+            sumIm = L::add(sumIm, L::add(L::mul(xRe, hIm), L::mul(xIm, hRe)));
+        }
+
+        L::storeComplex(&output[i][0], sumRe, sumIm);
+    }
+    return i;
+}
+
+/*
+  * @brief Direct-form FIR over whole vectors of output samples, for the first partition's taps: output[n] = Σ_k reversedCoefficients[k] input[n + k]
+  * @return First output sample not computed, as only whole vectors are
+*/
+template <typename L>
+static int headLanes(const float* input, const float* reversedCoefficients, int numTaps, float* output, int start, int numSamples)
+{
+    typedef typename L::Vec Vec;
+
+    int n = start;
+    for (; n + L::width <= numSamples; n += L::width)
+    {
+        const float* x = input + n;
+        Vec sum = L::set1(0.0);
+
+        for (int k = 0; k < numTaps; ++k)
+        {
+            sum = L::add(sum, L::mul(L::set1(reversedCoefficients[k]), L::load(x + k)));
+        }
+        L::store(output + n, sum);
+    }
+    return n;
+}
+
+/*
+  * @brief Gain of the incoming filter at a position in its crossfade. Positions before the crossfade starts, which a filter loaded part way through a partition
+  * gives the samples already read out, count as silent
+*/
+static inline float incomingGain(int position, int crossfadeLength)
+{
+    return position <= 0 ? 0.0f : (position < crossfadeLength ? (float)position / (float)crossfadeLength : 1.0f);
+}
+
+//==============================================================================
+HRTFPartitionedConvolver::HRTFPartitionedConvolver()
+{
+    partitionSize_ = 0;
+    numPartitions_ = 0;
+    firstTap_ = 0;
+    numBins_ = 0;
+    binStride_ = 0;
+    crossfadeLength_ = 1;
+    crossfadePosition_ = 1;
+    currentFilter_ = 0;
+    hasFilter_ = false;
+    fifoPosition_ = 0;
+    alignedBlocks_ = false;
+    tailReady_ = false;
+    filterSpectra_ = nullptr;
+    delayLine_ = nullptr;
+    delayLinePosition_ = 0;
+}
+
+/*
+  * @brief Choose the partition size from the host block size, allocate the delay line and create the FFTW plans. Must be called before process, and not on the audio
+  * thread. If the partition size has not changed, the existing plans are kept and only the state is cleared
+  * @param Largest number of samples that will be processed at once
+  * @param Number of samples over which the outgoing and incoming filters are crossfaded
+*/
+void HRTFPartitionedConvolver::prepare(int maximumBlockSize, int crossfadeLength)
+{
+    // One partition per host block keeps the cost of every block the same. The partitions divide the HRIR evenly, as both are powers of 2
+    const int partitionSize = jlimit(HRTF_PARTITION_MIN_SIZE, HRIR_SIZE, nextPowerOf2(jmax(1, maximumBlockSize)));
+    prepareSegment(partitionSize, 0, HRIR_SIZE, crossfadeLength);
+
+    // When the host block is a whole number of partitions, each block completes its partitions itself, so they can be convolved without waiting for the next block
+    alignedBlocks_ = maximumBlockSize % partitionSize == 0;
+}
+
+/*
+  * @brief Prepare to convolve with only a segment of each HRIR, as one stage of a longer convolution. Its output is the segment's convolution delayed by one partition,
+  * so a segment starting at least one partition into the HRIR lines up with the rest of the filter
+  * @param Partition size B, a power of 2 between HRTF_PARTITION_MIN_SIZE and HRIR_SIZE
+  * @param First tap of the segment
+  * @param Number of taps in the segment, a multiple of B
+  * @param Number of samples over which the outgoing and incoming filters are crossfaded
+*/
+void HRTFPartitionedConvolver::prepareSegment(int partitionSize, int firstTap, int numTaps, int crossfadeLength)
+{
+    jassert(isPowerOfTwo(partitionSize) && partitionSize >= HRTF_PARTITION_MIN_SIZE && partitionSize <= HRIR_SIZE);
+    jassert(numTaps % partitionSize == 0 && firstTap + numTaps <= HRIR_SIZE);
+
+    crossfadeLength_ = jmax(1, crossfadeLength);
+    // A segment's output is meant to be a partition late
+    alignedBlocks_ = false;
+
+    if (partitionSize != partitionSize_ || numTaps / partitionSize != numPartitions_ || firstTap != firstTap_)
+    {
+        release();
+
+        partitionSize_ = partitionSize;
+        numPartitions_ = jmax(1, numTaps / partitionSize_);
+        firstTap_ = firstTap;
+        numBins_ = partitionSize_ + 1;
+        binStride_ = (numBins_ + 7) & ~7;
+
+        filterSpectra_ = FFTWP(alloc_real)(HRTF_PARTITION_NUM_FILTERS * HRIR_NUM_EARS * numPartitions_ * 2 * binStride_);
+        delayLine_ = FFTWP(alloc_real)(HRIR_NUM_EARS * numPartitions_ * 2 * binStride_);
+
+        // Every transform is 2B points. The output batch runs over one or both filter slots, depending on whether a crossfade is in progress
+        inputBatch_.prepare(2 * partitionSize_, HRIR_NUM_EARS, FFTBatch::forwardTransforms);
+        outputBatch_.prepare(2 * partitionSize_, HRTF_PARTITION_NUM_FILTERS * HRIR_NUM_EARS, FFTBatch::backwardTransforms, true);
+        filterBatch_.prepare(2 * partitionSize_, HRIR_NUM_EARS * numPartitions_, FFTBatch::forwardTransforms);
+
+        inputFrames_.setSize(HRIR_NUM_EARS, 2 * partitionSize_);
+        outputFifo_.setSize(HRIR_NUM_EARS, partitionSize_);
+        tailOutput_.setSize(HRIR_NUM_EARS, partitionSize_);
+        headCoefficients_.setSize(HRTF_PARTITION_NUM_FILTERS * HRIR_NUM_EARS, partitionSize_);
+        headOutput_.setSize(HRTF_PARTITION_NUM_FILTERS, partitionSize_);
+
+        // A filter loaded before the partitions changed was stored for the old ones
+        hasFilter_ = false;
+        currentFilter_ = 0;
+    }
+
+    reset();
+}
+
+/*
+  * @brief Free the delay line, filter spectra and plans
+*/
+void HRTFPartitionedConvolver::release()
+{
+    if (partitionSize_ == 0)
+        return;
+
+    inputBatch_.release();
+    outputBatch_.release();
+    filterBatch_.release();
+
+    FFTWP(free)(filterSpectra_);
+    FFTWP(free)(delayLine_);
+    filterSpectra_ = nullptr;
+    delayLine_ = nullptr;
+
+    partitionSize_ = 0;
+    numPartitions_ = 0;
+    hasFilter_ = false;
+}
+
+/*
+  * @brief Clear the input history and delay line, and finish any crossfade in progress. The loaded filter is kept
+*/
+void HRTFPartitionedConvolver::reset()
+{
+    if (partitionSize_ == 0)
+        return;
+
+    inputFrames_.clear();
+    outputFifo_.clear();
+    fifoPosition_ = 0;
+    tailReady_ = false;
+
+    FloatVectorOperations::clear(delayLine_, HRIR_NUM_EARS * numPartitions_ * 2 * binStride_);
+    delayLinePosition_ = 0;
+
+    crossfadePosition_ = crossfadeLength_;
+}
+
+/*
+  * @brief Transform a new filter into partition spectra and start crossfading to it. Only runs prepared FFTW plans, so it does not allocate
+  * @param Per-ear filter to switch to
+*/
+void HRTFPartitionedConvolver::loadFilter(const HRTFFilter& filter)
+{
+    if (partitionSize_ == 0)
+        return;
+
+    // The first filter is loaded straight into place; after that the incoming filter goes into the idle slot and is faded in
+    const int targetFilter = hasFilter_ ? 1 - currentFilter_ : currentFilter_;
+
+    // Zero-pad each partition of B taps to 2B points. FFTW's IFFT is unnormalised, so its 1/2B scaling is folded into the filter here
+    const SpectralSample scale = (SpectralSample)1.0 / (2 * partitionSize_);
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        for (int p = 0; p < numPartitions_; ++p)
+        {
+            SpectralSample* partition = filterBatch_.getTimeDomain(ear * numPartitions_ + p);
+            const float* coefficients = filter.coefficients[ear] + firstTap_ + p * partitionSize_;
+
+            for (int n = 0; n < partitionSize_; ++n)
+            {
+                partition[n] = coefficients[n] * scale;
+                partition[partitionSize_ + n] = 0.0;
+            }
+        }
+
+        // The first partition is also kept in the time domain, reversed, for blocks that end part way through a partition
+        float* reversed = headCoefficients_.getWritePointer(targetFilter * HRIR_NUM_EARS + ear);
+        for (int n = 0; n < partitionSize_; ++n)
+        {
+            reversed[n] = filter.coefficients[ear][firstTap_ + partitionSize_ - 1 - n];
+        }
+    }
+
+    filterBatch_.forward();
+
+    // Split every partition's bins into the slot's real and imaginary arrays
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        for (int p = 0; p < numPartitions_; ++p)
+        {
+            const SpectralComplex* spectrum = filterBatch_.getFrequencyDomain(ear * numPartitions_ + p);
+            SpectralSample* real = getFilterSpectrum(targetFilter, ear, p);
+            SpectralSample* imag = real + binStride_;
+
+            for (int k = 0; k < binStride_; ++k)
+            {
+                real[k] = k < numBins_ ? spectrum[k][0] : 0.0;
+                imag[k] = k < numBins_ ? spectrum[k][1] : 0.0;
+            }
+        }
+    }
+
+    // Without latency, output is already being read from fifoPosition_, so the crossfade is counted from there rather than from the start of the partition
+    crossfadePosition_ = hasFilter_ ? (alignedBlocks_ ? -fifoPosition_ : 0) : crossfadeLength_;
+    currentFilter_ = targetFilter;
+    hasFilter_ = true;
+    // The later partitions' output, if already worked out for this partition, was for the outgoing filter alone
+    tailReady_ = false;
+}
+
+/*
+  * @brief Whether the previous filter is still being faded out. A new filter should only be loaded once this returns false
+*/
+bool HRTFPartitionedConvolver::isCrossfading() const
+{
+    return crossfadePosition_ < crossfadeLength_;
+}
+
+/*
+  * @brief Convolve each channel of the buffer in place with its ear's filter. Blocks of any size are accepted. When prepare found the host block to be whole partitions
+  * there is no delay: a partition that arrives whole is convolved by FFT in the call that brings it, while a block that ends part way through a partition pays for one
+  * inverse transform per partition, of the later partitions over earlier input, and then convolves the first partition's taps directly, B multiplies per sample. So
+  * however the host splits its blocks, no partition is transformed more than twice. Otherwise the output is delayed by one partition, as each partition is only
+  * transformed once all of its input has arrived
+  * @param Buffer with one channel per ear
+  * @param Number of samples to process
+*/
+void HRTFPartitionedConvolver::process(AudioSampleBuffer& buffer, int numSamples)
+{
+    const int numChannels = jmin(buffer.getNumChannels(), HRIR_NUM_EARS);
+
+    if (! hasFilter_)
+        return;
+
+    for (int start = 0; start < numSamples; )
+    {
+        // Exchange input for output up to the end of the current partition
+        const int span = jmin(numSamples - start, partitionSize_ - fifoPosition_);
+        const bool wholePartition = alignedBlocks_ && span == partitionSize_;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            FloatVectorOperations::copy(inputFrames_.getWritePointer(channel, partitionSize_ + fifoPosition_), buffer.getReadPointer(channel, start), span);
+        }
+
+        if (wholePartition)
+        {
+            transformInput();
+            convolvePartitions(0, outputFifo_);
+        }
+        else if (alignedBlocks_ && ! tailReady_)
+        {
+            convolvePartitions(1, tailOutput_);
+            tailReady_ = true;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* channelData = buffer.getWritePointer(channel, start);
+
+            if (alignedBlocks_ && ! wholePartition)
+                convolveHead(channel, channelData, span);
+            else
+                FloatVectorOperations::copy(channelData, outputFifo_.getReadPointer(channel, fifoPosition_), span);
+        }
+
+        fifoPosition_ += span;
+        start += span;
+
+        if (fifoPosition_ == partitionSize_)
+        {
+            // The next partitions need this one's spectrum in the delay line, however its output was worked out
+            if (! wholePartition)
+                transformInput();
+            if (! alignedBlocks_)
+                convolvePartitions(0, outputFifo_);
+
+            commitPartition();
+            fifoPosition_ = 0;
+        }
+    }
+}
+
+/*
+  * @brief Transform the overlap-save frame of the current partition, the previous partition's input followed by its own, into the next slot of the delay line
+*/
+void HRTFPartitionedConvolver::transformInput()
+{
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        SpectralSample* frame = inputBatch_.getTimeDomain(ear);
+        const float* input = inputFrames_.getReadPointer(ear);
+
+        for (int n = 0; n < 2 * partitionSize_; ++n)
+        {
+            frame[n] = input[n];
+        }
+    }
+
+    inputBatch_.forward();
+
+    // The newest spectrum overwrites the one that has passed through every partition
+    const int newestSlot = (delayLinePosition_ + 1) % numPartitions_;
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        const SpectralComplex* spectrum = inputBatch_.getFrequencyDomain(ear);
+        SpectralSample* real = getDelayLineSpectrum(ear, newestSlot);
+        SpectralSample* imag = real + binStride_;
+
+        for (int k = 0; k < numBins_; ++k)
+        {
+            real[k] = spectrum[k][0];
+            imag[k] = spectrum[k][1];
+        }
+    }
+}
+
+/*
+  * @brief Multiply-accumulate the delay line with each filter slot in use, from one partition on, transform back and crossfade the results. Partition p meets the
+  * input from p partitions before the current one, so from partition 1 on this only needs input that arrived before the current partition began
+  * @param First partition included: 0 for the whole filter, once transformInput has run, or 1 for all but the first partition
+  * @param Buffer receiving B samples per ear
+*/
+void HRTFPartitionedConvolver::convolvePartitions(int firstPartition, AudioSampleBuffer& output)
+{
+    const int B = partitionSize_;
+
+    if (firstPartition >= numPartitions_)
+    {
+        output.clear();
+        return;
+    }
+
+    // Run the current filter and, while crossfading, the outgoing filter over the same delay line
+    const int newestSlot = (delayLinePosition_ + 1) % numPartitions_;
+    const int fadeStart = crossfadePosition_;
+    const int numFilters = fadeStart < crossfadeLength_ ? HRTF_PARTITION_NUM_FILTERS : 1;
+    const int numPartitions = numPartitions_ - firstPartition;
+
+    for (int f = 0; f < numFilters; ++f)
+    {
+        const int filter = f == 0 ? currentFilter_ : 1 - currentFilter_;
+
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        {
+            const SpectralSample* inputSpectra[HRTF_PARTITION_MAX_PARTITIONS];
+            const SpectralSample* filterSpectra[HRTF_PARTITION_MAX_PARTITIONS];
+            for (int p = 0; p < numPartitions; ++p)
+            {
+                inputSpectra[p] = getDelayLineSpectrum(ear, (newestSlot - firstPartition - p + 2 * numPartitions_) % numPartitions_);
+                filterSpectra[p] = getFilterSpectrum(filter, ear, firstPartition + p);
+            }
+
+            SpectralComplex* spectrum = outputBatch_.getFrequencyDomain(f * HRIR_NUM_EARS + ear);
+            const int i = multiplyAccumulateLanes<NativeLanes>(inputSpectra, filterSpectra, numPartitions, binStride_, 0, numBins_, spectrum);
+            multiplyAccumulateLanes<TailLanes>(inputSpectra, filterSpectra, numPartitions, binStride_, i, numBins_, spectrum);
+        }
+    }
+
+    outputBatch_.backward(numFilters * HRIR_NUM_EARS);
+
+    // Only the second half of each 2B-point result is free of circular wrap-around
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        const SpectralSample* incoming = outputBatch_.getTimeDomain(ear) + B;
+        float* outputData = output.getWritePointer(ear);
+
+        if (numFilters == 1)
+        {
+            for (int n = 0; n < B; ++n)
+            {
+                outputData[n] = (float)incoming[n];
+            }
+            continue;
+        }
+
+        // During a crossfade mix the outgoing filter's output in with a linear ramp
+        const SpectralSample* outgoing = outputBatch_.getTimeDomain(HRIR_NUM_EARS + ear) + B;
+        for (int n = 0; n < B; ++n)
+        {
+            const float gain = incomingGain(fadeStart + n, crossfadeLength_);
+            outputData[n] = gain * (float)incoming[n] + (1.0f - gain) * (float)outgoing[n];
+        }
+    }
+}
+
+/*
+  * @brief Work out a span of the current partition's output without waiting for the rest of it: the first partition's taps convolved directly with the overlap-save
+  * frame, plus the later partitions' output from tailOutput_
+  * @param Ear
+  * @param Output samples, for the span that has just been written to the frame at fifoPosition_
+  * @param Number of samples
+*/
+void HRTFPartitionedConvolver::convolveHead(int ear, float* data, int numSamples)
+{
+    // Output sample n of the partition is frame sample B + n, which the first partition's reversed taps meet over frame samples n + 1 to B + n
+    const float* input = inputFrames_.getReadPointer(ear, fifoPosition_ + 1);
+    const float* tail = tailOutput_.getReadPointer(ear, fifoPosition_);
+    const int fadeStart = crossfadePosition_ + fifoPosition_;
+    const int numFilters = crossfadePosition_ < crossfadeLength_ ? HRTF_PARTITION_NUM_FILTERS : 1;
+
+    for (int f = 0; f < numFilters; ++f)
+    {
+        const int filter = f == 0 ? currentFilter_ : 1 - currentFilter_;
+        const float* coefficients = headCoefficients_.getReadPointer(filter * HRIR_NUM_EARS + ear);
+        float* headData = headOutput_.getWritePointer(f);
+
+        const int n = headLanes<NativeFloatLanes>(input, coefficients, partitionSize_, headData, 0, numSamples);
+        headLanes<TailFloatLanes>(input, coefficients, partitionSize_, headData, n, numSamples);
+    }
+
+    const float* incoming = headOutput_.getReadPointer(0);
+    if (numFilters == 1)
+    {
+        FloatVectorOperations::add(data, incoming, tail, numSamples);
+        return;
+    }
+
+    // The tail was crossfaded already, so only the head is mixed here
+    const float* outgoing = headOutput_.getReadPointer(1);
+    for (int n = 0; n < numSamples; ++n)
+    {
+        const float gain = incomingGain(fadeStart + n, crossfadeLength_);
+        data[n] = tail[n] + gain * incoming[n] + (1.0f - gain) * outgoing[n];
+    }
+}
+
+/*
+  * @brief Move on from a whole partition once its spectrum is in the delay line: it becomes the newest spectrum and the previous partition's input, and the crossfade
+  * advances over it
+*/
+void HRTFPartitionedConvolver::commitPartition()
+{
+    delayLinePosition_ = (delayLinePosition_ + 1) % numPartitions_;
+
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        float* input = inputFrames_.getWritePointer(ear);
+        FloatVectorOperations::copy(input, input + partitionSize_, partitionSize_);
+    }
+
+    crossfadePosition_ = jmin(crossfadeLength_, crossfadePosition_ + partitionSize_);
+    tailReady_ = false;
+}
+
+/*
+  * @brief Return the real parts of one partition's spectrum (first B + 1 bins) in a filter slot. The imaginary parts follow binStride_ later
+  * @param Filter slot
+  * @param Ear (0 = left, 1 = right)
+  * @param Partition number
+*/
+SpectralSample* HRTFPartitionedConvolver::getFilterSpectrum(int filter, int ear, int partition) const
+{
+    return filterSpectra_ + (((filter * HRIR_NUM_EARS + ear) * numPartitions_ + partition) * 2) * binStride_;
+}
+
+/*
+  * @brief Return the real parts of one input spectrum in the frequency-domain delay line. The imaginary parts follow binStride_ later
+  * @param Ear (0 = left, 1 = right)
+  * @param Delay line slot
+*/
+SpectralSample* HRTFPartitionedConvolver::getDelayLineSpectrum(int ear, int slot) const
+{
+    return delayLine_ + ((ear * numPartitions_ + slot) * 2) * binStride_;
+}
+
+/*
+  * @brief Partition size B, chosen from the host block size in prepare
+*/
+int HRTFPartitionedConvolver::getPartitionSize() const
+{
+    return partitionSize_;
+}
+
+/*
+  * @brief Delay added by the convolver, in samples: none when the host block is a whole number of partitions, and otherwise one partition
+*/
+int HRTFPartitionedConvolver::getLatencySamples() const
+{
+    return alignedBlocks_ ? 0 : partitionSize_;
+}
+
+HRTFPartitionedConvolver::~HRTFPartitionedConvolver()
+{
+    release();
+}
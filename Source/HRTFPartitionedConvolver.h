@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralTypes.h"
+#include "FFTBatch.h"
+#include "IRBank.h"
+#include "HRTFFilterSwap.h"
+
+#define HRTF_PARTITION_MIN_SIZE 32
+#define HRTF_PARTITION_MAX_PARTITIONS (HRIR_SIZE/HRTF_PARTITION_MIN_SIZE)
+// The outgoing and incoming filters while crossfading
+#define HRTF_PARTITION_NUM_FILTERS 2
+
+class HRTFPartitionedConvolver
+{
+public:
+    HRTFPartitionedConvolver();
+    ~HRTFPartitionedConvolver();
+
+    void prepare(int maximumBlockSize, int crossfadeLength);
+    void prepareSegment(int partitionSize, int firstTap, int numTaps, int crossfadeLength);
+    void release();
+    void reset();
+    void loadFilter(const HRTFFilter& filter);
+    void process(AudioSampleBuffer& buffer, int numSamples);
+    bool isCrossfading() const;
+    int getPartitionSize() const;
+    int getLatencySamples() const;
+
+private:
+    void transformInput();
+    void convolvePartitions(int firstPartition, AudioSampleBuffer& output);
+    void convolveHead(int ear, float* data, int numSamples);
+    void commitPartition();
+    SpectralSample* getFilterSpectrum(int filter, int ear, int partition) const;
+    SpectralSample* getDelayLineSpectrum(int ear, int slot) const;
+
+    // Uniformly partitioned overlap-save: the HRIR is split into P partitions of B samples, each transformed at 2B points. Every B input samples, the last 2B inputs
+    // are transformed, and the output is the sum of each partition's spectrum times the input spectrum from that many partitions ago
+    int partitionSize_;
+    int numPartitions_;
+    // First tap of the HRIR covered by the partitions, when the convolver is one stage of a longer convolution
+    int firstTap_;
+    int numBins_;
+    // Bins rounded up to a multiple of 8, so every split spectrum keeps the alignment of the first
+    int binStride_;
+    int crossfadeLength_;
+    int crossfadePosition_;
+    int currentFilter_;
+    bool hasFilter_;
+
+    // Overlap-save frame of each ear, the previous partition's input followed by the current one's as it is gathered at fifoPosition_, and the output read out over the
+    // same samples: the previous partition's, or with no latency the current one's
+    AudioSampleBuffer inputFrames_;
+    AudioSampleBuffer outputFifo_;
+    int fifoPosition_;
+    // Whether host blocks are whole partitions, so each partition is convolved as its input arrives, with no latency
+    bool alignedBlocks_;
+
+    // For blocks that end part way through a partition: the current partition's output from every partition of the filter but the first, worked out once per
+    // partition, the first partition's taps of both filter slots, time-reversed and laid out as [filter][ear], and their direct convolution for one ear
+    AudioSampleBuffer tailOutput_;
+    AudioSampleBuffer headCoefficients_;
+    AudioSampleBuffer headOutput_;
+    bool tailReady_;
+
+    // Partition spectra of both filter slots, laid out as [filter][ear][partition][real/imaginary][bin], and the frequency-domain delay line of input spectra, laid out as
+    // [ear][slot][real/imaginary][bin]. Slot delayLinePosition_ holds the newest spectrum. Both are split into real and imaginary parts so the bins load straight into lanes
+    SpectralSample* filterSpectra_;
+    SpectralSample* delayLine_;
+    int delayLinePosition_;
+
+    // Input frames of both ears, output spectra of both ears for each filter slot in use, and filter partitions of both ears
+    FFTBatch inputBatch_;
+    FFTBatch outputBatch_;
+    FFTBatch filterBatch_;
+
+    JUCE_DECLARE_NON_COPYABLE (HRTFPartitionedConvolver)
+};
@@ -0,0 +1,180 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "HRTFSpectralFilter.h"
+
+HRTFSpectralFilter::HRTFSpectralFilter()
+{
+    transformSize_ = 0;
+    numBins_ = 0;
+    binStride_ = 0;
+    prepared_ = false;
+    timeDomain_ = nullptr;
+    spectra_ = nullptr;
+    currentFilter_ = 0;
+    hasFilter_ = false;
+    crossfadeFrames_ = 1;
+
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        crossfadePosition_[ear] = crossfadeFrames_;
+}
+
+/*
+  * @brief Allocate the filter spectra and create the FFTW plan used to transform incoming filters. Must be called before apply, and not on the audio thread
+  * @param Transform size of the frames being filtered, at least (frame length + HRIR_SIZE - 1) to avoid circular aliasing
+  * @param Number of frames over which the outgoing and incoming filters are crossfaded
+*/
+void HRTFSpectralFilter::prepare(int transformSize, int crossfadeFrames)
+{
+    release();
+
+    transformSize_ = transformSize;
+    numBins_ = transformSize_/2 + 1;
+    binStride_ = numBins_ + 1;
+    crossfadeFrames_ = jmax(1, crossfadeFrames);
+
+    timeDomain_ = FFTWP(alloc_real)(transformSize_);
+    spectra_ = FFTWP(alloc_complex)(2 * HRIR_NUM_EARS * binStride_);
+
+    FFTWPlanner::loadWisdom();
+    const unsigned plannerFlags = FFTWPlanner::getPlannerFlags();
+    {
+        const ScopedLock plannerLock (FFTWPlanner::getLock());
+        forwardPlan_ = FFTWP(plan_dft_r2c_1d)(transformSize_, timeDomain_, spectra_, plannerFlags);
+    }
+
+    prepared_ = true;
+    hasFilter_ = false;
+    reset();
+}
+
+/*
+  * @brief Free the spectra and destroy the plan
+*/
+void HRTFSpectralFilter::release()
+{
+    if (prepared_ == false)
+        return;
+
+    {
+        const ScopedLock plannerLock (FFTWPlanner::getLock());
+        FFTWP(destroy_plan)(forwardPlan_);
+    }
+    FFTWP(free)(timeDomain_);
+    FFTWP(free)(spectra_);
+    timeDomain_ = nullptr;
+    spectra_ = nullptr;
+
+    prepared_ = false;
+}
+
+/*
+  * @brief Finish any crossfade in progress
+*/
+void HRTFSpectralFilter::reset()
+{
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        crossfadePosition_[ear] = crossfadeFrames_;
+}
+
+SpectralComplex* HRTFSpectralFilter::getSpectrum(int filter, int ear) const
+{
+    return spectra_ + (filter * HRIR_NUM_EARS + ear) * binStride_;
+}
+
+/*
+  * @brief Transform a new filter into the idle slot and start crossfading to it. Executes one FFT per ear, but does not allocate or lock
+  * @param Per-ear filter to switch to
+*/
+void HRTFSpectralFilter::loadFilter(const HRTFFilter& filter)
+{
+    if (prepared_ == false)
+        return;
+
+    // The first filter is loaded straight into place; after that the incoming filter goes into the idle slot and is faded in
+    const int targetFilter = hasFilter_ ? 1 - currentFilter_ : currentFilter_;
+
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        for (int i = 0; i < transformSize_; ++i)
+        {
+            timeDomain_[i] = i < HRIR_SIZE ? filter.coefficients[ear][i] : 0.0f;
+        }
+        FFTWP(execute_dft_r2c)(forwardPlan_, timeDomain_, getSpectrum(targetFilter, ear));
+
+        crossfadePosition_[ear] = hasFilter_ ? 0 : crossfadeFrames_;
+    }
+
+    currentFilter_ = targetFilter;
+    hasFilter_ = true;
+}
+
+/*
+  * @brief Whether the previous filter is still being faded out. A new filter should only be loaded once this returns false
+*/
+bool HRTFSpectralFilter::isCrossfading() const
+{
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        if (crossfadePosition_[ear] < crossfadeFrames_)
+            return true;
+    }
+    return false;
+}
+
+/*
+  * @brief Multiply one frame's spectrum by its ear's filter. During a crossfade the filter is interpolated between the outgoing and incoming spectra, one step per frame
+  * @param First K/2 + 1 bins of the zero-padded frame's spectrum, modified in place
+  * @param Number of bins
+  * @param Ear (0 = left, 1 = right), i.e. the channel the frame belongs to
+*/
+void HRTFSpectralFilter::apply(SpectralComplex* spectrum, int numBins, int ear)
+{
+    if (hasFilter_ == false || ear >= HRIR_NUM_EARS)
+        return;
+
+    jassert(numBins == numBins_);
+    numBins = jmin(numBins, numBins_);
+
+    const SpectralComplex* incoming = getSpectrum(currentFilter_, ear);
+
+    if (crossfadePosition_[ear] >= crossfadeFrames_)
+    {
+        for (int i = 0; i < numBins; i++)
+        {
+            const SpectralSample re = spectrum[i][0] * incoming[i][0] - spectrum[i][1] * incoming[i][1];
+            const SpectralSample im = spectrum[i][0] * incoming[i][1] + spectrum[i][1] * incoming[i][0];
+            spectrum[i][0] = re;
+            spectrum[i][1] = im;
+        }
+        return;
+    }
+
+    // The last frame of the crossfade uses the incoming filter alone
+    const SpectralComplex* outgoing = getSpectrum(1 - currentFilter_, ear);
+    const SpectralSample incomingGain = (SpectralSample)(crossfadePosition_[ear] + 1) / (SpectralSample)crossfadeFrames_;
+
+    for (int i = 0; i < numBins; i++)
+    {
+        const SpectralSample filterRe = outgoing[i][0] + incomingGain * (incoming[i][0] - outgoing[i][0]);
+        const SpectralSample filterIm = outgoing[i][1] + incomingGain * (incoming[i][1] - outgoing[i][1]);
+        const SpectralSample re = spectrum[i][0] * filterRe - spectrum[i][1] * filterIm;
+        const SpectralSample im = spectrum[i][0] * filterIm + spectrum[i][1] * filterRe;
+        spectrum[i][0] = re;
+        spectrum[i][1] = im;
+    }
+
+    ++crossfadePosition_[ear];
+}
+
+HRTFSpectralFilter::~HRTFSpectralFilter()
+{
+    release();
+}
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralTypes.h"
+#include "FFTWPlanner.h"
+#include "HRTFFilterSwap.h"
+
+// Applies the HRTF to the phase vocoder's zero-padded frames by multiplying their spectra, in place of a separate time domain convolution
+class HRTFSpectralFilter
+{
+public:
+    HRTFSpectralFilter();
+    ~HRTFSpectralFilter();
+
+    void prepare(int transformSize, int crossfadeFrames);
+    void release();
+    void reset();
+    void loadFilter(const HRTFFilter& filter);
+    void apply(SpectralComplex* spectrum, int numBins, int ear);
+    bool isCrossfading() const;
+
+private:
+    SpectralComplex* getSpectrum(int filter, int ear) const;
+
+    int transformSize_;
+    int numBins_;
+    // Spectra are spaced an even number of bins apart so each keeps the alignment of the first
+    int binStride_;
+    bool prepared_;
+
+    // Zero-padded HRIR, and the spectra of two filters for each ear
+    SpectralSample* timeDomain_;
+    SpectralComplex* spectra_;
+    SpectralPlan forwardPlan_;
+    int currentFilter_;
+    bool hasFilter_;
+
+    // Filters are crossfaded by interpolating their spectra over a number of frames, counted separately for each ear as the ears' frames are processed in turn
+    int crossfadeFrames_;
+    int crossfadePosition_[HRIR_NUM_EARS];
+
+    JUCE_DECLARE_NON_COPYABLE (HRTFSpectralFilter)
+};
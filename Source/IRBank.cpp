@@ -12,7 +12,21 @@
 
 IRBank::IRBank()
 {
-
+    built_ = false;
+    spectralCache_ = nullptr;
+    spectralCacheTransformSize_ = 0;
+    spectralCacheNumBins_ = 0;
+    spectralCacheBinStride_ = 0;
+    
+    for (int i = 0; i < BinaryData::namedResourceListSize; ++i)
+    {
+        impulseAzimuths_[i] = 0.0;
+        impulseElevations_[i] = 0.0;
+        impulseHasDirection_[i] = false;
+        
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+            onsetDelays_[i][ear] = 0.0;
+    }
 }
 
 /*
@@ -20,19 +34,23 @@ IRBank::IRBank()
 */
 void IRBank::build()
 {
+    // The HRIRs never change, so they (and their spectra) only need to be built the first time this is called
+    if (built_)
+        return;
+
     // Iterate through the list of binary resources (i.e. the HRIRs)
     for (int i = 0; i < BinaryData::namedResourceListSize; ++i)
     {
         const char* binaryData = 0;
         int binaryDataSize = 0;
-        
+
         // Extract HRIR from binary resource list
         binaryDataSize = HRIR_SIZE_FILE_SIZE;
         binaryData = BinaryData::getNamedResource(BinaryData::namedResourceList[i], binaryDataSize);
-        
+
         // Create a memory stream for that HRIR
         auto* inputStream = new MemoryInputStream (binaryData, binaryDataSize, false);
-        
+
         // Create WAV format reader for this stream
         WavAudioFormat format;
         reader = format.createReaderFor (inputStream, true);  // takes ownership
@@ -42,14 +60,238 @@ void IRBank::build()
         {
             int streamNumChannels = reader->numChannels;
             int streamNumSamples = (int)reader->lengthInSamples;
-            
+
         bufferArray[i] = juce::AudioBuffer<float>(streamNumChannels, streamNumSamples);
         reader->read(&bufferArray[i], 0, streamNumSamples, 0, true, true);
         }
+        
+        // Record the direction the HRIR was measured at, from the name of the file it was embedded from
+        impulseHasDirection_[i] = parseDirection(BinaryData::getNamedResourceOriginalFilename(BinaryData::namedResourceList[i]), impulseAzimuths_[i], impulseElevations_[i]);
     }
+
+    buildSpectralCache();
+    built_ = true;
 }
 
-IRBank::~IRBank()
+/*
+  * @brief Split every HRIR for each ear into its onset delay and a minimum-phase spectrum, and keep them so that IRCrossfade can blend straight from them.
+  * Minimum-phase responses all start together, so blending them (and their delays separately) does not comb filter the way blending the measured responses does
+*/
+void IRBank::buildSpectralCache()
 {
+    // The FFT of a real signal is conjugate symmetric, so only the first K/2 + 1 bins are kept
+    spectralCacheTransformSize_ = HRIR_SPECTRUM_TRANSFORM_SIZE;
+    spectralCacheNumBins_ = spectralCacheTransformSize_/2 + 1;
+    spectralCacheBinStride_ = (spectralCacheNumBins_ + 7) & ~7;
+    
+    if (spectralCache_ == nullptr)
+    {
+        spectralCache_ = FFTWP(alloc_real)(BinaryData::namedResourceListSize * HRIR_NUM_EARS * 2 * spectralCacheBinStride_);
+    }
+    
+    // Both ears of an HRIR go through the real cepstrum together, as a batch of M = HRIR_CEPSTRUM_OVERSAMPLING * K point transforms. The minimum-phase responses
+    // of every HRIR are then transformed at the cache's size in a single batch. Planning measures (and overwrites) the batch arrays, so they are only filled afterwards
+    const int cepstrumSize = HRIR_CEPSTRUM_OVERSAMPLING * spectralCacheTransformSize_;
+    const int cepstrumNumBins = cepstrumSize/2 + 1;
+    const int numSpectra = BinaryData::namedResourceListSize * HRIR_NUM_EARS;
+    FFTBatch cepstrumBatch, spectrumBatch;
+    cepstrumBatch.prepare(cepstrumSize, HRIR_NUM_EARS);
+    spectrumBatch.prepare(spectralCacheTransformSize_, numSpectra, FFTBatch::forwardTransforms);
+    
+    for (int i = 0; i < BinaryData::namedResourceListSize; ++i)
+    {
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        {
+            // Zero-pad the HRIR up to the cepstrum size, in case the resource is shorter than expected
+            const int numSamples = jmin(bufferArray[i].getNumSamples(), HRIR_SIZE);
+            const float* impulseData = bufferArray[i].getReadPointer(jmin(ear, bufferArray[i].getNumChannels() - 1));
+            SpectralSample* timeDomain = cepstrumBatch.getTimeDomain(ear);
+            
+            onsetDelays_[i][ear] = findOnset(impulseData, numSamples);
+            
+            for (int n = 0; n < cepstrumSize; n++)
+            {
+                timeDomain[n] = n < numSamples ? impulseData[n] : 0.0;
+            }
+        }
+        
+        // Real cepstrum: the inverse FFT of the log magnitude (floored, so silent bins stay finite)
+        cepstrumBatch.forward();
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        {
+            SpectralComplex* frequencyDomain = cepstrumBatch.getFrequencyDomain(ear);
+            for (int k = 0; k < cepstrumNumBins; k++)
+            {
+                const SpectralSample magnitude = std::sqrt(frequencyDomain[k][0] * frequencyDomain[k][0] + frequencyDomain[k][1] * frequencyDomain[k][1]);
+                frequencyDomain[k][0] = std::log(jmax(magnitude, (SpectralSample)1.0e-6));
+                frequencyDomain[k][1] = 0.0;
+            }
+        }
+        cepstrumBatch.backward();
+        
+        // Fold the cepstrum onto positive quefrencies, which makes its spectrum the log of the minimum-phase response with the same magnitude. The 1/M scaling
+        // of the inverse FFT is folded in here too
+        const SpectralSample cepstrumScale = (SpectralSample)1.0 / cepstrumSize;
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        {
+            SpectralSample* timeDomain = cepstrumBatch.getTimeDomain(ear);
+            timeDomain[0] *= cepstrumScale;
+            for (int n = 1; n < cepstrumSize/2; n++)
+            {
+                timeDomain[n] *= 2 * cepstrumScale;
+            }
+            timeDomain[cepstrumSize/2] *= cepstrumScale;
+            for (int n = cepstrumSize/2 + 1; n < cepstrumSize; n++)
+            {
+                timeDomain[n] = 0.0;
+            }
+        }
+        
+        // Exponentiate back to the minimum-phase spectrum, and return to the time domain
+        cepstrumBatch.forward();
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        {
+            SpectralComplex* frequencyDomain = cepstrumBatch.getFrequencyDomain(ear);
+            for (int k = 0; k < cepstrumNumBins; k++)
+            {
+                const SpectralSample magnitude = std::exp(frequencyDomain[k][0]) * cepstrumScale;
+                const SpectralSample phase = frequencyDomain[k][1];
+                frequencyDomain[k][0] = magnitude * std::cos(phase);
+                frequencyDomain[k][1] = magnitude * std::sin(phase);
+            }
+        }
+        cepstrumBatch.backward();
+        
+        // Truncate the minimum-phase response to the HRIR length (its energy is packed at the start, so little is lost) and zero-pad it to the cache's transform size
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        {
+            const SpectralSample* minimumPhase = cepstrumBatch.getTimeDomain(ear);
+            SpectralSample* timeDomain = spectrumBatch.getTimeDomain(i * HRIR_NUM_EARS + ear);
+            for (int n = 0; n < spectralCacheTransformSize_; n++)
+            {
+                timeDomain[n] = n < HRIR_SIZE ? minimumPhase[n] : 0.0;
+            }
+        }
+    }
+    
+    // Transform every minimum-phase response at once, then split the bins into each HRIR's real and imaginary arrays
+    spectrumBatch.forward();
+    for (int spectrum = 0; spectrum < numSpectra; ++spectrum)
+    {
+        const SpectralComplex* frequencyDomain = spectrumBatch.getFrequencyDomain(spectrum);
+        SpectralSample* real = spectralCache_ + (spectrum * 2) * spectralCacheBinStride_;
+        SpectralSample* imag = real + spectralCacheBinStride_;
+        for (int k = 0; k < spectralCacheBinStride_; k++)
+        {
+            real[k] = k < spectralCacheNumBins_ ? frequencyDomain[k][0] : 0.0;
+            imag[k] = k < spectralCacheNumBins_ ? frequencyDomain[k][1] : 0.0;
+        }
+    }
+}
 
+/*
+  * @brief Find where an HRIR's response begins, i.e. the first sample to reach HRIR_ONSET_THRESHOLD of its peak
+  * @param HRIR samples
+  * @param Number of samples
+  * @return Onset in samples
+*/
+int IRBank::findOnset(const float* impulse, int numSamples)
+{
+    float peak = 0.0f;
+    for (int n = 0; n < numSamples; n++)
+    {
+        peak = jmax(peak, std::abs(impulse[n]));
+    }
+    
+    const float threshold = (float)HRIR_ONSET_THRESHOLD * peak;
+    for (int n = 0; n < numSamples; n++)
+    {
+        if (peak > 0.0f && std::abs(impulse[n]) >= threshold)
+            return n;
+    }
+    return 0;
+}
+
+/*
+  * @brief Return the real parts of the cached minimum-phase spectrum (first K/2 + 1 bins) of one HRIR for one ear
+  * @param HRIR list number
+  * @param Ear (0 = left, 1 = right)
+*/
+const SpectralSample* IRBank::getSpectrumReal(int index, int channel) const
+{
+    return spectralCache_ + ((index * HRIR_NUM_EARS + channel) * 2) * spectralCacheBinStride_;
+}
+
+/*
+  * @brief Return the imaginary parts of the cached minimum-phase spectrum of one HRIR for one ear
+  * @param HRIR list number
+  * @param Ear (0 = left, 1 = right)
+*/
+const SpectralSample* IRBank::getSpectrumImag(int index, int channel) const
+{
+    return getSpectrumReal(index, channel) + spectralCacheBinStride_;
+}
+
+/*
+  * @brief Return the onset delay that was removed from one HRIR to make its cached minimum-phase spectrum
+  * @param HRIR list number
+  * @param Ear (0 = left, 1 = right)
+  * @return Delay in samples
+*/
+double IRBank::getOnsetDelay(int index, int channel) const
+{
+    return onsetDelays_[index][channel];
+}
+
+/*
+  * @brief Return the FFT size the cached spectra were computed with
+*/
+int IRBank::getSpectrumTransformSize() const
+{
+    return spectralCacheTransformSize_;
+}
+
+/*
+  * @brief Return the number of HRIRs in the bank, including any resources without a direction
+*/
+int IRBank::getNumImpulses() const
+{
+    return BinaryData::namedResourceListSize;
+}
+
+/*
+  * @brief Return the direction an HRIR was measured at
+  * @param HRIR list number
+  * @param Set to the azimuth in degrees, between 0 and 360
+  * @param Set to the elevation in degrees
+  * @return Whether the HRIR has a direction, i.e. its resource name could be parsed
+*/
+bool IRBank::getDirection(int index, double& azimuth, double& elevation) const
+{
+    azimuth = impulseAzimuths_[index];
+    elevation = impulseElevations_[index];
+    return impulseHasDirection_[index];
+}
+
+/*
+  * @brief Parse the direction out of an HRIR's file name, which has the form "<list number>azi_<azimuth>_ele_<elevation>.wav" with a comma as the decimal separator,
+  * e.g. "12azi_60,0_ele_-30,0.wav"
+  * @param Original file name of the resource
+  * @param Set to the azimuth in degrees
+  * @param Set to the elevation in degrees
+  * @return Whether the name had that form
+*/
+bool IRBank::parseDirection(const String& filename, double& azimuth, double& elevation)
+{
+    if (filename.contains("azi_") == false || filename.contains("_ele_") == false)
+        return false;
+    
+    azimuth = filename.fromFirstOccurrenceOf("azi_", false, false).upToFirstOccurrenceOf("_ele_", false, false).replaceCharacter(',', '.').getDoubleValue();
+    elevation = filename.fromFirstOccurrenceOf("_ele_", false, false).upToLastOccurrenceOf(".", false, false).replaceCharacter(',', '.').getDoubleValue();
+    return true;
+}
+
+IRBank::~IRBank()
+{
+    FFTWP(free)(spectralCache_);
 }
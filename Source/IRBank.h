@@ -10,10 +10,22 @@
 
 #pragma once
 #include "JuceHeader.h"
+#include "SpectralTypes.h"
+#include "FFTWPlanner.h"
+#include "FFTBatch.h"
+#include "Util.h"
 #include <iostream>
 #include <string>
 #define HRIR_SIZE 256
 #define HRIR_SIZE_FILE_SIZE 1068
+#define HRIR_NUM_EARS 2
+// The HRIRs are stored as minimum-phase spectra at twice their length, so that once the onset delay is put back the delayed response is truncated rather than
+// wrapped around
+#define HRIR_SPECTRUM_TRANSFORM_SIZE (2*HRIR_SIZE)
+// Minimum-phase spectra are derived through the real cepstrum, computed at this multiple of the HRIR length to keep its time aliasing negligible
+#define HRIR_CEPSTRUM_OVERSAMPLING 8
+// Level, relative to the peak, at which each HRIR's onset is detected
+#define HRIR_ONSET_THRESHOLD 0.1
 
 class IRBank
 {
@@ -22,10 +34,37 @@ public:
     ~IRBank();
     
     void build();
+    const SpectralSample* getSpectrumReal(int index, int channel) const;
+    const SpectralSample* getSpectrumImag(int index, int channel) const;
+    int getSpectrumTransformSize() const;
+    double getOnsetDelay(int index, int channel) const;
+    int getNumImpulses() const;
+    bool getDirection(int index, double& azimuth, double& elevation) const;
     
     AudioFormatReader* reader;
     int streamNumChannels;
     int streamNumSamples;
     
     AudioSampleBuffer bufferArray[BinaryData::namedResourceListSize];
+    
+private:
+    void buildSpectralCache();
+    static int findOnset(const float* impulse, int numSamples);
+    static bool parseDirection(const String& filename, double& azimuth, double& elevation);
+    
+    bool built_;
+    
+    // Direction of every HRIR in degrees, parsed from its resource name, and whether the name held one
+    double impulseAzimuths_[BinaryData::namedResourceListSize];
+    double impulseElevations_[BinaryData::namedResourceListSize];
+    bool impulseHasDirection_[BinaryData::namedResourceListSize];
+    
+    // Minimum-phase spectrum of every HRIR, for each ear, and the onset delay in samples that was removed to make it. The spectra are stored split into
+    // real and imaginary parts, laid out as [HRIR][ear][real/imaginary][bin], so blending can load a vector of bins straight from each
+    SpectralSample* spectralCache_;
+    double onsetDelays_[BinaryData::namedResourceListSize][HRIR_NUM_EARS];
+    int spectralCacheTransformSize_;
+    int spectralCacheNumBins_;
+    // Bins rounded up to a multiple of 8, so every array keeps the alignment of the first
+    int spectralCacheBinStride_;
 };
@@ -14,161 +14,120 @@ IRCrossfade::IRCrossfade()
 {
     fftImpulseScaleFactor_ = 0.0;
     fftImpulseActualTransformSize_ = 0;
+    fftImpulseOnsetDelay_ = 0.0;
+    
+    for (int i = 0; i < HRIR_GRID_NUM_NEIGHBOURS; ++i)
+    {
+        fftImpulsefrequencyDomainReal_[i] = nullptr;
+        fftImpulsefrequencyDomainImag_[i] = nullptr;
+        fftImpulseWeights_[i] = 0.0;
+    }
+    
+    // Planned once, on whichever thread constructs the blend (the processor's or the dense grid's owner), so synthesise never plans
     initFFT();
 }
 
 /*
-  * @brief Initialise FFTW objects and methods that are to be used in loadImpulses, impulseFFTBlend and backwardFFTandStore
+  * @brief Initialise FFTW objects and methods that are to be used in impulseFFTBlend and backwardFFTandStore. Does nothing if they already exist
 */
 void IRCrossfade::initFFT()
 {
-    //Ensure FFT size is a power of 2, and set FFT coefficient scaling value (1/K)
-    fftImpulseActualTransformSize_ = nextPowerOf2(HRIR_SIZE);
+    if (fftImpulseActualTransformSize_ != 0)
+        return;
+    
+    //Use the transform size of the IRBank's spectral cache, and set FFT coefficient scaling value (1/K)
+    fftImpulseActualTransformSize_ = HRIR_SPECTRUM_TRANSFORM_SIZE;
     fftImpulseScaleFactor_ = 1.0/fftImpulseActualTransformSize_;
     
-    // Utilise FFTW's wrapper function to allocate memory for the complex arrays used to store information in both the time and frequency domain
-    fftImpulseTimeDomain_1 = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulseTimeDomain_2 = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulseTimeDomain_3 = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulseTimeDomain_4 = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulsefrequencyDomain_1 = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulsefrequencyDomain_2 = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulsefrequencyDomain_3 = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulsefrequencyDomain_4 = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulseTimeDomain_Product = fftw_alloc_complex(fftImpulseActualTransformSize_);
-    fftImpulsefrequencyDomain_Product = fftw_alloc_complex(fftImpulseActualTransformSize_);
+    // The blend only needs to be kept in one ear's channel of the buffer at a time, so it is sized once here rather than on every blend
+    crossfadedImpulse.setSize(HRIR_NUM_EARS, HRIR_SIZE);
+    crossfadedImpulse.clear();
     
-    // Create 1-dimensional FFT and IFFT plans through FFTW's fftw_plan_dft_1d method
-    fftwImpulseForwardPlan_1 = fftw_plan_dft_1d(fftImpulseActualTransformSize_, fftImpulseTimeDomain_1,fftImpulsefrequencyDomain_1, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftwImpulseForwardPlan_2 = fftw_plan_dft_1d(fftImpulseActualTransformSize_, fftImpulseTimeDomain_2,fftImpulsefrequencyDomain_2, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftwImpulseForwardPlan_3 = fftw_plan_dft_1d(fftImpulseActualTransformSize_, fftImpulseTimeDomain_3,fftImpulsefrequencyDomain_3, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftwImpulseForwardPlan_4 = fftw_plan_dft_1d(fftImpulseActualTransformSize_, fftImpulseTimeDomain_4,fftImpulsefrequencyDomain_4, FFTW_FORWARD, FFTW_ESTIMATE);
-    fftwImpulseBackwardPlan_ = fftw_plan_dft_1d(fftImpulseActualTransformSize_, fftImpulsefrequencyDomain_Product, fftImpulseTimeDomain_Product, FFTW_BACKWARD, FFTW_ESTIMATE);
+    // Create a batched complex-to-real IFFT plan covering both ears. The forward FFTs of the HRIRs are done once by IRBank
+    fftImpulseBatch_.prepare(fftImpulseActualTransformSize_, HRIR_NUM_EARS, FFTBatch::backwardTransforms);
 }
 
 /*
-  * @brief Load impulse responses into arrays of type fftw_complex and perform a forward-FFT on each
-  * @param Channel number (whichever is presently being interated through inside processBlock in the DafxBinauralPhaseVocoderAudioProcessor class)
-  * @param Nearest HRIR to the lower left of the user's azimuth/elevation choice
-  * @param Nearest HRIR to the upper left of the user's azimuth/elevation choice
-  * @param Nearest HRIR to the lower right of the user's azimuth/elevation choice
-  * @param Nearest HRIR to the upper right of the user's azimuth/elevation choice
+  * @brief Select the cached minimum-phase spectra and onset delays of the 4 impulse responses surrounding the source, for one channel
+  * @param Channel number (whichever is presently being interated through inside updateHRTF in the DafxBinauralPhaseVocoderAudioProcessor class)
+  * @param The bank holding the HRIRs and their precomputed spectra
+  * @param The 4 HRIRs surrounding the user's azimuth/elevation choice, and their interpolation weights, as found by HRIRGrid
 */
-void IRCrossfade::loadImpulses(int channel, AudioSampleBuffer impulse1, AudioSampleBuffer impulse2, AudioSampleBuffer impulse3, AudioSampleBuffer impulse4)
+void IRCrossfade::loadImpulses(int channel, const IRBank& irBank, const HRIRSelection& selection)
 {
-    // Get write pointers to the 4 HRIRs passed into this method as parameters
-    float* startIR1 = impulse1.getWritePointer(channel);
-    float* startIR2 = impulse2.getWritePointer(channel);
-    float* startIR3 = impulse3.getWritePointer(channel);
-    float* startIR4 = impulse4.getWritePointer(channel);
+    // The cache is built at the same transform size as the blend, so the spectra can be read from directly
+    jassert(irBank.getSpectrumTransformSize() == fftImpulseActualTransformSize_);
     
-    // All IRs are the sample length
-    int LengthIR = impulse1.getNumSamples();
+    fftImpulseOnsetDelay_ = 0.0;
     
-    // Copy the AudioSampleBuffer buffers into vectors of type float
-    std::vector<float> impulse1vec (startIR1, startIR1 + LengthIR);
-    std::vector<float> impulse2Vec (startIR2, startIR2 + LengthIR);
-    std::vector<float> impulse3Vec (startIR3, startIR3 + LengthIR);
-    std::vector<float> impulse4Vec (startIR4, startIR4 + LengthIR);
+    for (int i = 0; i < HRIR_GRID_NUM_NEIGHBOURS; ++i)
+    {
+        fftImpulsefrequencyDomainReal_[i] = irBank.getSpectrumReal(selection.impulses[i], channel);
+        fftImpulsefrequencyDomainImag_[i] = irBank.getSpectrumImag(selection.impulses[i], channel);
+        fftImpulseWeights_[i] = (SpectralSample)selection.weights[i];
+        fftImpulseOnsetDelay_ += selection.weights[i] * irBank.getOnsetDelay(selection.impulses[i], channel);
+    }
+}
 
-    // Load these vectors into the real dimension of their corresponding fftImpulseTimeDomain_1 arrays, and 0 the imaginary dimension
-    for (int i = 0; i < fftImpulseActualTransformSize_; i++)
+/*
+  * @brief Blend the spectra of the loaded impulse responses as their weighted sum, and delay the result by their weighted onset delay
+  * @param Channel number, i.e. which ear's spectrum in the batch to store the blend in
+*/
+void IRCrossfade::impulseFFTBlend(int channel)
+{
+    // The minimum-phase responses are aligned, so a weighted sum interpolates between them without comb filtering. The onset delay is then put back as a linear phase
+    // shift of -2πkd/K at bin k. The 1/K scaling of the IFFT is folded into the weights
+    // Only the first K/2 + 1 bins are needed as the FFT of a real signal is always conjugate symmetric
+    SpectralSample weights[HRIR_GRID_NUM_NEIGHBOURS];
+    for (int n = 0; n < HRIR_GRID_NUM_NEIGHBOURS; ++n)
     {
-        fftImpulseTimeDomain_1[i][0] = impulse1vec[i];
-        fftImpulseTimeDomain_1[i][1] = 0.0;
-        fftImpulseTimeDomain_2[i][0] = impulse2Vec[i];
-        fftImpulseTimeDomain_2[i][1] = 0.0;
-        fftImpulseTimeDomain_3[i][0] = impulse3Vec[i];
-        fftImpulseTimeDomain_3[i][1] = 0.0;
-        fftImpulseTimeDomain_4[i][0] = impulse4Vec[i];
-        fftImpulseTimeDomain_4[i][1] = 0.0;
+        weights[n] = fftImpulseWeights_[n] * (SpectralSample)fftImpulseScaleFactor_;
     }
     
-    // Execute forward FFTs on these 4 fftw_complex arrays
-    fftw_execute(fftwImpulseForwardPlan_1);
-    fftw_execute(fftwImpulseForwardPlan_2);
-    fftw_execute(fftwImpulseForwardPlan_3);
-    fftw_execute(fftwImpulseForwardPlan_4);
+    HRTFBlendKernels::blend(fftImpulsefrequencyDomainReal_, fftImpulsefrequencyDomainImag_, weights, HRIR_GRID_NUM_NEIGHBOURS, fftImpulseActualTransformSize_/2 + 1,
+                            -2.0 * M_PI * fftImpulseOnsetDelay_ / fftImpulseActualTransformSize_, fftImpulseBatch_.getFrequencyDomain(channel));
 }
 
 /*
-  * @brief Perform 4-way complex multiplication on the spectral data of the loaded impulse responses
+  * @brief Perform backwards FFT on the frequency domain products of every ear calculated in impulseFFTBlend, as one batch, and store them in AudioSampleBuffer crossfadedImpulse
+  * @param Number of input channels
 */
-void IRCrossfade::impulseFFTBlend()
+void IRCrossfade::backwardFFTandStore(int numberOfInputChannels)
 {
-    // (a + bi)(c + di)(e + fi)(g + hi) = (eacg-ebdg-adfg-bcfg-eadh-ebch-acfh+bdfh) + i(each+eadg+ebcg-ebdh+acfg-adfh-bcfh-bdfg)
-    // Only iterate through half the transform size as the FFT of a real signal is always conjugate symmetric
-    for (int i = 0; i < fftImpulseActualTransformSize_/2; i++)
+    fftImpulseBatch_.backward();
+    
+    jassert(numberOfInputChannels <= crossfadedImpulse.getNumChannels());
+    
+    for (int channel = 0; channel < numberOfInputChannels; ++channel)
     {
-        //Real
-        fftImpulsefrequencyDomain_Product[i][0] =
-        
-        (( (fftImpulsefrequencyDomain_3[i][0] * fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][0] * fftImpulsefrequencyDomain_4[i][0])
-            
-          - (fftImpulsefrequencyDomain_3[i][0] *  fftImpulsefrequencyDomain_1[i][1] * fftImpulsefrequencyDomain_2[i][1] * fftImpulsefrequencyDomain_4[i][0])
-          
-          - (fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][1] * fftImpulsefrequencyDomain_3[i][1] * fftImpulsefrequencyDomain_4[i][0])
-          
-          - (fftImpulsefrequencyDomain_1[i][1] * fftImpulsefrequencyDomain_2[i][0] * fftImpulsefrequencyDomain_3[i][i] * fftImpulsefrequencyDomain_4[i][0])
-          
-          - (fftImpulsefrequencyDomain_3[i][0] * fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][1] * fftImpulsefrequencyDomain_4[i][1])
-          
-          - (fftImpulsefrequencyDomain_3[i][0] * fftImpulsefrequencyDomain_1[i][1] * fftImpulsefrequencyDomain_2[i][0] * fftImpulsefrequencyDomain_4[i][1])
-          
-          - (fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][0] * fftImpulsefrequencyDomain_3[i][1] * fftImpulsefrequencyDomain_4[i][1])
-          
-          - (fftImpulsefrequencyDomain_1[i][1] * fftImpulsefrequencyDomain_2[i][1] * fftImpulsefrequencyDomain_3[i][1] * fftImpulsefrequencyDomain_4[i][1])
-          
-          * fftImpulseScaleFactor_));
-        
-        
-        //Imaginary
-        fftImpulsefrequencyDomain_Product[i][1] =
-        
-        (( (fftImpulsefrequencyDomain_3[i][0] * fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][0] * fftImpulsefrequencyDomain_4[i][1])
-          
-          + (fftImpulsefrequencyDomain_3[i][0] * fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][1] * fftImpulsefrequencyDomain_4[i][0])
-          
-          + (fftImpulsefrequencyDomain_3[i][0] * fftImpulsefrequencyDomain_1[i][1] * fftImpulsefrequencyDomain_2[i][0] * fftImpulsefrequencyDomain_4[i][0])
-          
-          - (fftImpulsefrequencyDomain_3[i][0] * fftImpulsefrequencyDomain_1[i][1] * fftImpulsefrequencyDomain_2[i][1] * fftImpulsefrequencyDomain_4[i][1])
-          
-          + (fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][0] * fftImpulsefrequencyDomain_3[i][1] * fftImpulsefrequencyDomain_4[i][0])
-          
-          - (fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][1] * fftImpulsefrequencyDomain_3[i][1] * fftImpulsefrequencyDomain_4[i][1])
-          
-          - (fftImpulsefrequencyDomain_1[i][1] * fftImpulsefrequencyDomain_2[i][0] * fftImpulsefrequencyDomain_3[i][1] * fftImpulsefrequencyDomain_4[i][1])
-          
-          - (fftImpulsefrequencyDomain_1[i][0] * fftImpulsefrequencyDomain_2[i][1] * fftImpulsefrequencyDomain_3[i][1] * fftImpulsefrequencyDomain_4[i][0])
-          
-           * fftImpulseScaleFactor_));
+        float* crossfadedImpulseData = crossfadedImpulse.getWritePointer(channel);
+        const SpectralSample* blendedImpulse = fftImpulseBatch_.getTimeDomain(channel);
         
-        //Maintain conjugate symmetry
-        if (i != 0)
+        // Iterate through the HRIR length, setting each sample of the crossfadedImpulse buffer to its corresponding sample of the transformed blend. The rest of the
+        // transform only holds the tail pushed past the HRIR length by the onset delay, which is dropped
+        for (int i = 0; i < HRIR_SIZE; i++)
         {
-            fftImpulsefrequencyDomain_Product[fftImpulseActualTransformSize_ - i][0] = fftImpulsefrequencyDomain_Product[i][0];
-            fftImpulsefrequencyDomain_Product[fftImpulseActualTransformSize_ - i][1] = fftImpulsefrequencyDomain_Product[i][1];
+            crossfadedImpulseData[i] = (float)blendedImpulse[i];
         }
     }
 }
 
 /*
-  * @brief Perform backwards FFT on frequency domain projduct calculated in impulseFFTBlend and store in AudioSampleBuffer crossfadedImpulse
-  * @param Channel number (whichever is presently being interated through inside processBlock in the DafxBinauralPhaseVocoderAudioProcessor class)
-  * @param Number of input channels
+  * @brief Synthesise the HRTF for both ears from the 4 surrounding HRIRs and store it, normalised, in a filter ready for the convolver
+  * @param The bank holding the HRIRs and their precomputed spectra
+  * @param The 4 HRIRs surrounding the source, and their interpolation weights, as found by HRIRGrid
+  * @param Filter to store the result in
 */
-void IRCrossfade::backwardFFTandStore(int channel, int numberOfInputChannels)
+void IRCrossfade::synthesise(const IRBank& irBank, const HRIRSelection& selection, HRTFFilter& filter)
 {
-    fftw_execute(fftwImpulseBackwardPlan_);
-    
-    crossfadedImpulse.setSize(numberOfInputChannels, HRIR_SIZE);
-    float* crossfadedImpulseData = crossfadedImpulse.getWritePointer(channel);
-    
-    // Iterate through FFT size, setting each sample of the crossfadedImpulse buffer to its corresponding sample in the fftw_complex object fftImpulseTimeDomain_Product
-    for (int i = 0; i < fftImpulseActualTransformSize_; i++)
+    for (int channel = 0; channel < HRIR_NUM_EARS; ++channel)
     {
-        crossfadedImpulseData[i] = fftImpulseTimeDomain_Product[i][0];
+        loadImpulses(channel, irBank, selection);
+        impulseFFTBlend(channel);
     }
+    backwardFFTandStore(HRIR_NUM_EARS);
+    
+    filter.copyFrom(crossfadedImpulse, true);
 }
 
 /*
@@ -176,23 +135,11 @@ void IRCrossfade::backwardFFTandStore(int channel, int numberOfInputChannels)
 */
 void IRCrossfade::deinitFFT()
 {
-    fftw_destroy_plan(fftwImpulseForwardPlan_1);
-    fftw_destroy_plan(fftwImpulseForwardPlan_2);
-    fftw_destroy_plan(fftwImpulseForwardPlan_3);
-    fftw_destroy_plan(fftwImpulseForwardPlan_4);
-    fftw_destroy_plan(fftwImpulseBackwardPlan_);
-    
-    fftw_free(fftImpulseTimeDomain_1);
-    fftw_free(fftImpulseTimeDomain_2);
-    fftw_free(fftImpulseTimeDomain_3);
-    fftw_free(fftImpulseTimeDomain_4);
-    fftw_free(fftImpulseTimeDomain_Product);
+    if (fftImpulseActualTransformSize_ == 0)
+        return;
     
-    fftw_free(fftImpulsefrequencyDomain_1);
-    fftw_free(fftImpulsefrequencyDomain_2);
-    fftw_free(fftImpulsefrequencyDomain_3);
-    fftw_free(fftImpulsefrequencyDomain_4);
-    fftw_free(fftImpulsefrequencyDomain_Product);
+    fftImpulseBatch_.release();
+    fftImpulseActualTransformSize_ = 0;
 }
 
 IRCrossfade::~IRCrossfade()
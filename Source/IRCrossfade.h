@@ -11,8 +11,13 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <api/fftw3.h>
+#include "SpectralTypes.h"
+#include "FFTWPlanner.h"
+#include "FFTBatch.h"
 #include "IRBank.h"
+#include "HRIRGrid.h"
+#include "HRTFFilterSwap.h"
+#include "HRTFBlendKernels.h"
 #include "Util.h"
 #include <cmath>
 
@@ -23,10 +28,11 @@ public:
     ~IRCrossfade();
     
     void initFFT();
-    void loadImpulses(int channel, AudioSampleBuffer impulse1, AudioSampleBuffer impulse2, AudioSampleBuffer impulse3, AudioSampleBuffer impulse4);
-    void impulseFFTBlend();
-    void backwardFFTandStore(int channel, int numberOfInputChannels);
+    void loadImpulses(int channel, const IRBank& irBank, const HRIRSelection& selection);
+    void impulseFFTBlend(int channel);
+    void backwardFFTandStore(int numberOfInputChannels);
     void deinitFFT();
+    void synthesise(const IRBank& irBank, const HRIRSelection& selection, HRTFFilter& filter);
     
     AudioSampleBuffer crossfadedImpulse;
         
@@ -36,21 +42,14 @@ private:
     int fftImpulseActualTransformSize_;
     double fftImpulseScaleFactor_;
     
-    //FFTW
-    fftw_complex *fftImpulseTimeDomain_1,
-    *fftImpulseTimeDomain_2,
-    *fftImpulseTimeDomain_3,
-    *fftImpulseTimeDomain_4,
-    *fftImpulseTimeDomain_Product,
-    *fftImpulsefrequencyDomain_1,
-    *fftImpulsefrequencyDomain_2,
-    *fftImpulsefrequencyDomain_3,
-    *fftImpulsefrequencyDomain_4,
-    *fftImpulsefrequencyDomain_Product;
+    //Minimum-phase spectra of the 4 selected HRIRs as split real and imaginary parts, pointing into the IRBank's spectral cache, with their interpolation weights
+    const SpectralSample* fftImpulsefrequencyDomainReal_[HRIR_GRID_NUM_NEIGHBOURS];
+    const SpectralSample* fftImpulsefrequencyDomainImag_[HRIR_GRID_NUM_NEIGHBOURS];
+    SpectralSample fftImpulseWeights_[HRIR_GRID_NUM_NEIGHBOURS];
+    // Weighted onset delay of the 4 HRIRs in samples, put back onto the blended minimum-phase response
+    double fftImpulseOnsetDelay_;
     
-    fftw_plan fftwImpulseForwardPlan_1,
-    fftwImpulseForwardPlan_2,
-    fftwImpulseForwardPlan_3,
-    fftwImpulseForwardPlan_4,
-    fftwImpulseBackwardPlan_;
+    //FFTW
+    // The blended spectrum of each ear, and its response once transformed back, both ears going through the IFFT in one batch
+    FFTBatch fftImpulseBatch_;
 };
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "ITDTable.h"
+#include "Util.h"
+
+ITDTable::ITDTable()
+{
+    build(44100.0);
+}
+
+/*
+  * @brief Fill the table for a sample rate. The lateral angle θ of each direction, measured from the median plane, gives the extra path round the head to the far ear,
+  * a/c (θ + sin θ), and the near ear is not delayed at all
+  * @param Host sample rate
+*/
+void ITDTable::build(double sampleRate)
+{
+    for (int row = 0; row < ITD_TABLE_NUM_ELEVATIONS; ++row)
+    {
+        const double elevation = deg2rad((double)(row * ITD_TABLE_ELEVATION_STEP - 90));
+
+        for (int column = 0; column < ITD_TABLE_NUM_AZIMUTHS; ++column)
+        {
+            // Positive azimuths are to the listener's right, where the left ear is the far one. Raising the source takes it towards the median plane
+            const double azimuth = deg2rad((double)(column * ITD_TABLE_AZIMUTH_STEP));
+            const double sinLateral = jlimit(-1.0, 1.0, std::sin(azimuth) * std::cos(elevation));
+            const double lateral = std::asin(std::abs(sinLateral));
+            const double delay = ITD_HEAD_RADIUS / ITD_SPEED_OF_SOUND * (lateral + std::abs(sinLateral)) * sampleRate;
+
+            delays_[row][column][0] = sinLateral > 0.0 ? (float)delay : 0.0f;
+            delays_[row][column][1] = sinLateral < 0.0 ? (float)delay : 0.0f;
+        }
+    }
+}
+
+/*
+  * @brief Look up each ear's delay for a source direction, interpolating linearly between the surrounding grid points
+  * @param Azimuth in radians, any finite value, wrapped round to 0-2π. Taken as straight ahead if not finite
+  * @param Elevation in degrees, limited to ±90°. Taken as level if not finite
+  * @param Left ear delay in samples
+  * @param Right ear delay in samples
+*/
+void ITDTable::getDelays(double azimuth, double elevation, double& leftDelay, double& rightDelay) const
+{
+    // A NaN or infinite angle would survive the wrap and the limit below and turn into an index outside the table
+    if (! std::isfinite(azimuth))
+        azimuth = 0.0;
+    if (! std::isfinite(elevation))
+        elevation = 0.0;
+
+    double azimuthDegrees = std::fmod(rad2deg(azimuth), 360.0);
+    if (azimuthDegrees < 0.0)
+        azimuthDegrees += 360.0;
+
+    const double x = azimuthDegrees / ITD_TABLE_AZIMUTH_STEP;
+    const int column = jmin((int)x, ITD_TABLE_NUM_AZIMUTHS - 2);
+    const double fx = x - column;
+
+    const double y = (jlimit(-90.0, 90.0, elevation) + 90.0) / ITD_TABLE_ELEVATION_STEP;
+    const int row = jmin((int)y, ITD_TABLE_NUM_ELEVATIONS - 2);
+    const double fy = y - row;
+
+    double delays[HRIR_NUM_EARS];
+    for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+    {
+        const double lower = delays_[row][column][ear] + fx * (delays_[row][column + 1][ear] - delays_[row][column][ear]);
+        const double upper = delays_[row + 1][column][ear] + fx * (delays_[row + 1][column + 1][ear] - delays_[row + 1][column][ear]);
+        delays[ear] = lower + fy * (upper - lower);
+    }
+
+    leftDelay = delays[0];
+    rightDelay = delays[1];
+}
+
+ITDTable::~ITDTable()
+{
+
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "IRBank.h"
+
+// Spherical-head model: an average adult head radius in metres, and the speed of sound in m/s
+#define ITD_HEAD_RADIUS 0.0875
+#define ITD_SPEED_OF_SOUND 343.0
+// Largest interaural delay the model produces for either ear, from a source level with one ear: a/c (π/2 + 1), about 0.66 ms
+#define ITD_MAX_SECONDS (ITD_HEAD_RADIUS / ITD_SPEED_OF_SOUND * (M_PI / 2.0 + 1.0))
+
+// Spacing of the table in degrees. At 2° by 5° it holds 181 x 37 pairs of delays, about 53 KB, with the 0° column repeated at 360° so lookups never wrap
+#define ITD_TABLE_AZIMUTH_STEP 2
+#define ITD_TABLE_ELEVATION_STEP 5
+#define ITD_TABLE_NUM_AZIMUTHS (360 / ITD_TABLE_AZIMUTH_STEP + 1)
+#define ITD_TABLE_NUM_ELEVATIONS (180 / ITD_TABLE_ELEVATION_STEP + 1)
+
+// Each ear's interaural delay in samples, worked out from Woodworth's spherical-head formula for every point of an azimuth/elevation grid at the host sample rate,
+// so a source position is turned into delays by interpolating between four table entries
+class ITDTable
+{
+public:
+    ITDTable();
+    ~ITDTable();
+
+    void build(double sampleRate);
+    void getDelays(double azimuth, double elevation, double& leftDelay, double& rightDelay) const;
+
+private:
+    // Delays laid out as [elevation][azimuth][ear], from -90° and 0° respectively
+    float delays_[ITD_TABLE_NUM_ELEVATIONS][ITD_TABLE_NUM_AZIMUTHS][HRIR_NUM_EARS];
+
+    JUCE_DECLARE_NON_COPYABLE (ITDTable)
+};
@@ -354,6 +354,7 @@ void DafxBinauralPhaseVocoderAudioProcessorEditor::sliderValueChanged(Slider* sl
     else if (sliderThatWasMoved == elevationSlider_)
     {
         processor.elevation = elevationSlider_->getValue();
+        processor.updateHRTF();
     }
     else if (sliderThatWasMoved == distanceSlider_)
     {
@@ -368,6 +369,7 @@ void DafxBinauralPhaseVocoderAudioProcessorEditor::sliderValueChanged(Slider* sl
 void DafxBinauralPhaseVocoderAudioProcessorEditor::sourceLocationChanged(float azimuth)
 {
     processor.azimuth = azimuth;
+    processor.updateHRTF();
 }
 
 /*
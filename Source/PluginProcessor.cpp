@@ -27,25 +27,20 @@ DafxBinauralPhaseVocoderAudioProcessor::DafxBinauralPhaseVocoderAudioProcessor()
 
 // Initialise values that are assigned and used in following functions
 {
-    fftActualTransformSize_ = 512;
-    inputBufferLength_ = 1;
-    outputBufferLength_ = 1;
-    inputBufferWritePosition_ = outputBufferWritePosition_ = outputBufferReadPosition_ = 0;
-    samplesSinceLastFFT_ = 0;
-    windowBuffer_ = 0;
-    windowBufferLength_ = 0;
+    // Default STFT configuration: 512-point FFT, no overlap and a rectangular window
+    stftEngine.setConfiguration(512, 1, STFTEngine::rectangularWindow);
     preparedToPlay_ = false;
-    fftSignalScaleFactor_ = 0.0;
-    phase = 0.0;
+    vocoderAccuracy = VocoderKernels::highAccuracy;
+    whisperSeed = 0;
     
-    Ldelay_ = 0.0;
-    Rdelay_ = 0.0;
-    leftEarDelayPosition_ = 0.0;
-    rightEarDelayPosition_ = 0.0;
-    c_ = 343;
     azimuth = 0.0;
     elevation = 0;
     hasRun = false;
+    fusedHRTF = false;
+    denseHRTFGrid = true;
+    fusedHRTFActive_ = false;
+    hrtfConvolverMode = HRTFConvolverSelector::automaticConvolver;
+    hrtfConvolverActive_ = HRTFConvolverSelector::directConvolver;
     
     reverbParameters.dryLevel = 1.0;
     reverbParameters.wetLevel = 0.0;
@@ -68,84 +63,219 @@ DafxBinauralPhaseVocoderAudioProcessor::~DafxBinauralPhaseVocoderAudioProcessor(
 */
 void DafxBinauralPhaseVocoderAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    // Create an instance of the the IRBank class, which loads impulse responses into an array of type AudioBuffer
+    // Choose the convolver first, as the first call at a block size times them all (later ones return the same choice straight away). The producer lock is not held
+    // yet, so the editor's updateHRTF is never kept waiting by the timing
+    const bool fused = fusedHRTF;
+    const int convolverChoice = fused ? HRTFConvolverSelector::directConvolver : HRTFConvolverSelector::choose(hrtfConvolverMode, samplesPerBlock);
+    
+    // Keep the editor's updateHRTF out until the bank, the blend and the first filter are all in place
+    const ScopedLock producerLock (hrtfProducerLock_);
+    
+    // Create an instance of the the IRBank class, which loads impulse responses into an array of type AudioBuffer and caches their spectra
     irBank.build();
+    // Index the HRIRs by the directions in their names, so the ones surrounding any source position can be looked up directly
+    if (hrirGrid.isBuilt() == false)
+        hrirGrid.build(irBank);
+    // Every stage takes blocks of any size up to this one, so it need not be a power of 2
     bufferSize = samplesPerBlock;
-    
-    if (isPowerOfTwo(bufferSize) == false)
-    {
-        throw std::invalid_argument("bufferSize must be a power of 2");
-    }
 
-    // Prepare the DSP specifications that are used to initialise our instance of the JUCE convolution class
-    dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumOutputChannels();
-    
     // Set sample rate of our instance of the JUCE reveb class, and reset its buffer
     reverb.setSampleRate(sampleRate);
     reverb.reset();
     
-    // Set the window buffer length, scale factor (used to scale coefficients after the IFFT) and hopsize
-    windowBufferLength_ = fftActualTransformSize_;
-    fftSignalScaleFactor_ = 1.0 / fftActualTransformSize_;
-    hopActualSize_ = fftActualTransformSize_;
+    // Initialise the STFT engine behind the phase vocoder with its configured FFT size, overlap and window. Its delay, plus that of the HRTF stage and the shortest
+    // interaural delay, is reported to the host
+    // In fused mode its frames are zero-padded so the HRTF can be applied to their spectra, and the separate convolver is bypassed
+    fusedHRTFActive_ = fused;
+    stftEngine.setFilterLength(fusedHRTFActive_ ? HRIR_SIZE : 1);
+    stftEngine.prepare(getTotalNumInputChannels(), samplesPerBlock);
+    int hrtfLatency = 0;
     
-    // As we are using a rectangular window, the windowBuffer_ array is filled with window coefficients of 1.0
-    windowBuffer_ = (double *)malloc(fftActualTransformSize_ * sizeof(double));
-    for (int i = 0; i < fftActualTransformSize_; i++)
+    if (fusedHRTFActive_)
     {
-        windowBuffer_[i] = 1.0;
+        // The HRTF crossfade steps once per frame, so its length is rounded to a whole number of hops
+        const int crossfadeFrames = (int)std::ceil(HRTF_CROSSFADE_SECONDS * sampleRate / stftEngine.getHopSize());
+        hrtfSpectralFilter.prepare(stftEngine.getTransformSize(), crossfadeFrames);
+        hrtfPartitionedConvolver.release();
+        hrtfHybridConvolver.release();
+    }
+    else
+    {
+        // Otherwise a binaural convolver runs after the vocoder, crossfading between the outgoing and incoming HRTFs whenever the source moves. Unless one is asked for,
+        // the quickest at the host block size of those that need no latency was chosen above by timing them, so the timing never changes the latency. A partitioned
+        // FFT convolver asked for at a block size that is not whole partitions adds one partition to the vocoder's delay
+        hrtfSpectralFilter.release();
+        hrtfConvolverActive_ = convolverChoice;
+        const int crossfadeLength = (int)(HRTF_CROSSFADE_SECONDS * sampleRate);
+        
+        if (hrtfConvolverActive_ == HRTFConvolverSelector::partitionedConvolver)
+        {
+            hrtfPartitionedConvolver.prepare(samplesPerBlock, crossfadeLength);
+            hrtfLatency = hrtfPartitionedConvolver.getLatencySamples();
+        }
+        else if (hrtfConvolverActive_ == HRTFConvolverSelector::hybridConvolver)
+        {
+            hrtfHybridConvolver.prepare(samplesPerBlock, crossfadeLength);
+            hrtfLatency = hrtfHybridConvolver.getLatencySamples();
+        }
+        else
+        {
+            hrtfConvolver.prepare(samplesPerBlock, crossfadeLength);
+            hrtfLatency = hrtfConvolver.getLatencySamples();
+        }
+        
+        // Only the chosen convolver keeps its FFTW plans and delay lines
+        if (hrtfConvolverActive_ != HRTFConvolverSelector::partitionedConvolver)
+            hrtfPartitionedConvolver.release();
+        if (hrtfConvolverActive_ != HRTFConvolverSelector::hybridConvolver)
+            hrtfHybridConvolver.release();
     }
     
-    // Initialise the FFTW objects and methods used in the phase vocoder inside processBlock and IRCrossfade
-    initFFT(fftActualTransformSize_);
-    impulseResponseCrossfade.initFFT();
+    // Restart each channel's random phase sequence from the seed, so that renders with the same seed are identical
+    for (int channel = 0; channel < STFT_MAX_CHANNELS; ++channel)
+    {
+        randomPhaseGenerators_[channel].setSeed(whisperSeed + channel);
+    }
     
-    // Initialise an empty delay buffer to hold the most recent 2 seconds worth of samples
-    delayBufferLength_ = (int)(2.0*sampleRate);
-    if(delayBufferLength_ < 1)    // Sanity check to ensure buffer length is positive and non-zero
-        delayBufferLength_ = 1;
-    delayBuffer_.setSize(getTotalNumInputChannels(), delayBufferLength_);
-    delayBuffer_.clear();
+    // Work out each ear's delay across the azimuth/elevation grid for this sample rate, and initialise an empty delay line just long enough for the largest of them.
+    // The interpolator keeps even the leading ear at least FRACTIONAL_DELAY_MIN_SAMPLES behind, so that much is added to the reported latency
+    itdTable_.build(sampleRate);
+    interauralDelay_.prepare(getTotalNumInputChannels(), (int)std::ceil(ITD_MAX_SECONDS*sampleRate + FRACTIONAL_DELAY_MIN_SAMPLES), samplesPerBlock);
+    setLatencySamples(stftEngine.getLatencySamples() + hrtfLatency + (int)FRACTIONAL_DELAY_MIN_SAMPLES);
     
-    // Ensure that our instance of the JUCE convolution object is reset and prepared
-    juceConvolution.reset();
-    juceConvolution.prepare(spec);
+    // Now the HRIR bank is loaded, synthesise and publish the filter for the current source position
+    preparedToPlay_ = true;
+    hrtfPosition_.reset();
+    updateHRTF();
+    
+    // Keep any plans FFTW measured for this configuration, so the next load with it skips the measurement
+    FFTWPlanner::saveWisdom();
+    
+    // Synthesise the HRTF for every point of a dense grid in the background, if asked to. Until it is ready, or without it, updateHRTF blends each HRTF as the source
+    // moves, through the cache. Turning the grid off frees it, which the producer lock held here makes safe
+    if (denseHRTFGrid)
+        hrtfDenseGrid_.startBuilding(irBank, hrirGrid);
+    else
+        hrtfDenseGrid_.release();
 }
 
 /*
-  * @brief Initialise FFTW objects and methods that are to be used in processBlock
-  * @param FFT length
+  * @brief Synthesise the HRTF for the current azimuth and elevation and publish it to the audio thread. Called from the message thread whenever the source is moved, and
+  * does nothing (the last filter stays in use) until the source has moved by at least the hysteresis threshold from where that filter was synthesised. Also called from
+  * prepareToPlay, so calls are serialised by hrtfProducerLock_
 */
-void DafxBinauralPhaseVocoderAudioProcessor::initFFT(int FFTLength)
+void DafxBinauralPhaseVocoderAudioProcessor::updateHRTF()
 {
-    // Utilise FFTW's wrapper function to allocate memory for the complex arrays used to store information in both the time and frequency domain inside processBlock
-    fftSignalTimeDomain_ = fftw_alloc_complex(fftActualTransformSize_);
-    fftSignalFrequencyDomain_ = fftw_alloc_complex(fftActualTransformSize_);
-
-
-    // Create 1-dimensional FFT and IFFT plans through FFTW's fftw_plan_dft_1d method
-    fftwSignalForwardPlan_ = fftw_plan_dft_1d(FFTLength, fftSignalTimeDomain_,
-                                       fftSignalFrequencyDomain_, FFTW_FORWARD, FFTW_ESTIMATE);
+    const ScopedLock producerLock (hrtfProducerLock_);
     
-    fftwSignalBackwardPlan_ = fftw_plan_dft_1d(FFTLength, fftSignalFrequencyDomain_,
-                                       fftSignalTimeDomain_, FFTW_BACKWARD, FFTW_ESTIMATE);
+    // The HRIR bank is only loaded in prepareToPlay
+    if (preparedToPlay_ == false)
+        return;
     
-    // Initialise and resize arrays used to store samples in intermediate stages of the phase vododer
-    inputBufferLength_ = FFTLength;
-    inputBuffer_.setSize(2, inputBufferLength_);
-    inputBuffer_.clear();
-    outputBufferLength_ = 2*FFTLength;
-    outputBuffer_.setSize(2, outputBufferLength_);
-    outputBuffer_.clear();
+    if (hrtfPosition_.update(azimuth, elevation) == false)
+        return;
     
-    // Initialise counters and read pointers
-    inputBufferWritePosition_ = 0;
-    samplesSinceLastFFT_ = 0;
-    outputBufferReadPosition_ = 0;
+    if (hrtfDenseGrid_.isReady())
+    {
+        // Take the ready-made filter at the nearest point of the dense grid
+        hrtfFilterSwap.getWriteFilter() = hrtfDenseGrid_.getFilter(hrtfPosition_.getAzimuth(), hrtfPosition_.getElevation());
+    }
+    else
+    {
+        // Directions are rounded to the cache's grid, so a source returning to a recent direction reuses the filter blended for it last time
+        double cacheAzimuth = hrtfPosition_.getAzimuth();
+        double cacheElevation = hrtfPosition_.getElevation();
+        HRTFFilterCache::quantise(cacheAzimuth, cacheElevation);
+        
+        const HRTFFilter* cachedFilter = hrtfFilterCache.find(cacheAzimuth, cacheElevation);
+        if (cachedFilter == nullptr)
+        {
+            // Blend the 4 impulse responses surrounding the direction, using the weighted sum of their spectra and IFFT in impulseResponseCrossfade, straight into a new cache entry
+            HRTFFilter& newFilter = hrtfFilterCache.insert(cacheAzimuth, cacheElevation);
+            impulseResponseCrossfade.synthesise(irBank, hrirGrid.lookup(cacheAzimuth, cacheElevation), newFilter);
+            cachedFilter = &newFilter;
+        }
+        hrtfFilterSwap.getWriteFilter() = *cachedFilter;
     }
+    
+    // Hand the new filter to the audio thread without locking; if it has not picked up the previous one yet, that one is simply replaced
+    hrtfFilterSwap.publish();
+}
+
+/*
+  * @brief Set how far the source must move before a new HRTF is synthesised. Call from the message thread
+  * @param Hysteresis threshold in degrees of arc (0 to resynthesise on any movement)
+*/
+void DafxBinauralPhaseVocoderAudioProcessor::setHRTFThreshold(double degrees)
+{
+    const ScopedLock producerLock (hrtfProducerLock_);
+    hrtfPosition_.setThreshold(degrees);
+}
+
+/*
+  * @brief Choose the STFT configuration of the phase vocoder. Takes effect on the next call to prepareToPlay
+  * @param FFT size, between 128 and 4096
+  * @param Hop size as a fraction of the FFT size: 1 (no overlap), 2 (1/2) or 4 (1/4)
+  * @param Window type (STFTEngine::rectangularWindow, hannWindow or sqrtHannWindow)
+*/
+void DafxBinauralPhaseVocoderAudioProcessor::setSTFTConfiguration(int fftSize, int hopDivisor, int windowType)
+{
+    stftEngine.setConfiguration(fftSize, hopDivisor, windowType);
+}
+
+/*
+  * @brief Phase vocoder: called by the STFT engine with the spectrum of each frame
+  * @param First N/2 + 1 bins of the frame's spectrum, modified in place
+  * @param Number of bins
+  * @param Channel the frame belongs to
+*/
+void DafxBinauralPhaseVocoderAudioProcessor::processSpectrum(SpectralComplex* spectrum, int numBins, int channel)
+{
+    // As the FFT of a real signal is always conjugate symmetric, the r2c plan only outputs bins 0 to N/2, and the c2r plan implies F(N-k) from them
+    // Amplitudes are multiplied by the inverse of the user-specified sound source distance
+    const double gain = 1.0/distance;
+
+    // If user has selected pass-through, recover original phase information
+    if (passthrough)
+    {
+        VocoderKernels::passthrough(spectrum, numBins, gain, vocoderAccuracy);
+    }
+    // If user has selected the robotisation effect, set phase value to 0.0
+    else if (robotisation)
+    {
+        VocoderKernels::robotise(spectrum, numBins, gain, vocoderAccuracy);
+    }
+    // If user has selected the whisperisation effect, replace the phase value with a random number between 0-2π, drawn from this channel's own generator
+    else if (whisperisation)
+    {
+        // At fast accuracy the random phases come straight from a table of unit phasors, which skips cos and sin altogether
+        if (vocoderAccuracy == VocoderKernels::fastAccuracy)
+        {
+            randomPhaseGenerators_[channel].fillPhasors(randomPhasors_, numBins);
+            VocoderKernels::whisperise(spectrum, numBins, gain, randomPhasors_);
+        }
+        else
+        {
+            randomPhaseGenerators_[channel].fillPhases(randomPhases_, numBins);
+            VocoderKernels::whisperise(spectrum, numBins, gain, randomPhases_, vocoderAccuracy);
+        }
+    }
+
+}
+
+/*
+  * @brief Apply the HRTF to the spectrum of one zero-padded frame, after the vocoder effect has been applied to it and it has been resynthesised and windowed. Only
+  * called by the STFT engine in fused mode
+  * @param First K/2 + 1 bins of the padded frame's spectrum, modified in place
+  * @param Number of bins
+  * @param Channel the frame belongs to
+*/
+void DafxBinauralPhaseVocoderAudioProcessor::filterSpectrum(SpectralComplex* spectrum, int numBins, int channel)
+{
+    // In fused mode the HRTF is applied here, rather than by convolving the resynthesised signal. The frame was tapered at its own length first, so robotisation and
+    // whisperisation, which spread each frame over the whole of it, are filtered exactly as the separate convolver would filter them
+    hrtfSpectralFilter.apply(spectrum, numBins, channel);
+}
 
 /*
   * @brief Perform audio processing on block of input samples
@@ -157,267 +287,58 @@ void DafxBinauralPhaseVocoderAudioProcessor::processBlock (AudioBuffer<float>& b
     // Toggle whether the function is bypassed or not (i.e. whether the incoming audio is processed or passed through)
     if (bypass == false)
     {
+        // Marks this thread as real-time, so that in BPV_AUDIO_THREAD_GUARD builds any allocation or planner lock taken below is reported
+        AudioThreadGuard::ScopedRealtime realtime;
         ScopedNoDenormals noDenormals;
         auto totalNumInputChannels  = getTotalNumInputChannels();
         auto totalNumOutputChannels = getTotalNumOutputChannels();
-        int sampleRate = getSampleRate();
-        int channel, inwritepos, sampssincefft, dwp, lrp, rrp;
-        int outreadpos, outwritepos;
+        const int numSamples = buffer.getNumSamples();
         
         // In case we have more outputs than inputs, clear any output channels that don't contain input data
         for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         {
-            buffer.clear (i, 0, bufferSize);
+            buffer.clear (i, 0, numSamples);
         }
         
         // Adjust revert wet level to the mapped distance reading from the GUI: the reverb increases as the distance increases
         reverbParameters.wetLevel = 0.0 + ((0.1 - 0.0) / (20 - 1)) * (distance - 1);
         reverb.setParameters(reverbParameters);
         // Process left and right channels with reverb
-        reverb.processStereo (buffer.getWritePointer(0), buffer.getWritePointer(1), bufferSize);
-
-        // Initialise a 'process' buffer, which is used inside the phase vocoder and time delay arcitectures
-        AudioSampleBuffer processBuffer;
-        processBuffer.setSize(totalNumInputChannels, bufferSize);
-        processBuffer = buffer;
-        buffer.clear();
+        reverb.processStereo (buffer.getWritePointer(0), buffer.getWritePointer(1), numSamples);
 
-        // Initialise an instance of the the impulse state machine, which selects the 4 impulse responses closest to the user's selected azimuth and elevation angles
-        ImpulseSelectionStateMachine impulseStateMachine;
-        impulseStateMachine.stateMachine (azimuth, elevation);
-
-        //Iterate through the input channels
-        for (channel = 0; channel < totalNumInputChannels; ++channel)
+        // Pick up a newly synthesised HRTF, if the source has moved, once any previous crossfade has finished. The filter is only copied or transformed by prepared plans, never allocated, on this thread
+        if (isHRTFCrossfading() == false)
         {
-            // Attain writable pointer to the the process buffer
-            float* processData = processBuffer.getWritePointer(channel);
-
-            // inputBuffer_ is the circular buffer for collecting input samples for the FFT
-            float* inputBufferData = inputBuffer_.getWritePointer(jmin (channel, inputBuffer_.getNumChannels() - 1));
-            float* outputBufferData = outputBuffer_.getWritePointer(jmin (channel, inputBuffer_.getNumChannels() - 1));
-
-            // State variables temporarily cached for each channel so the two channel can have independent behaviour
-            inwritepos = inputBufferWritePosition_;
-            outwritepos = outputBufferWritePosition_;
-            outreadpos = outputBufferReadPosition_;
-            sampssincefft = samplesSinceLastFFT_;
-
-            // Iterate through the samples in the buffer
-            for (int i = 0; i < bufferSize; ++i)
-            {
-                const float in = processData[i];
-
-                // Store the next buffered sample in the output. Do this first before anything changes the output buffer. Set the result to 0 when finished in preparation for the next overlap/add procedure
-                processData[i] = outputBufferData[outreadpos];
-                outputBufferData[outreadpos] = 0.0;
-                if(++outreadpos >= outputBufferLength_)
-                    outreadpos = 0;
-
-                // Store current sample in input buffer
-                inputBufferData[inwritepos] = in;
-                // Increment the write pointer
-                if (++inwritepos >= inputBufferLength_)
-                {
-                    inwritepos = 0;
-                }
-                // Also increment how many samples we've stored since last transform; if it reaches the hop size, perform an FFT, and subsequent convolution
-                if (++sampssincefft >= hopActualSize_)
-                {
-                    sampssincefft = 0;
-
-                    // Where N >= buffer, this will be inwritepos. Modulo precaution is for larger buffers
-                    int inputBufferStartPosition = (inwritepos + inputBufferLength_
-                                                    - fftActualTransformSize_) % inputBufferLength_;
-
-                    int inputBufferIndex = inputBufferStartPosition;
-                    for (int fftBufferIndex = 0; fftBufferIndex < fftActualTransformSize_; fftBufferIndex++)
-                    {
-                        // Set real part to windowed signal, imaginary part to 0
-                        fftSignalTimeDomain_[fftBufferIndex][1] = 0.0;
-
-                        // Safety check for if the window isn't ready
-                        if (fftBufferIndex >= windowBufferLength_)
-                        {
-                            fftSignalTimeDomain_[fftBufferIndex][0] = 0.0;
-                        }
-                        // Fill real dimension of fftSignalTimeDomain_ array with the input data (stored in the inputBufferData vector) multiplied by 1.0 (the rectangular window)
-                        else {
-                            fftSignalTimeDomain_[fftBufferIndex][0] = windowBuffer_[fftBufferIndex] * inputBufferData[inputBufferIndex];
-                        }
-
-                        inputBufferIndex++;
-                        if (inputBufferIndex >= inputBufferLength_)
-                        {
-                            inputBufferIndex = 0;
-                        }
-                    }
-
-                    // Perform FFT on windowed data, inputting the signal in fftSignalTimeDomain_ and outputting fftFrequencyDomain_
-                    fftw_execute(fftwSignalForwardPlan_);
-
-                    // Phase vocoder
-                    // As the FFT of a real signal is always conjugate symmetric, we only need to iterate through half the FFT size
-                    for (int i = 0; i < fftActualTransformSize_/2; i++)
-                    {
-                        // Recover amplitude information, multiplied by the inverse of the user-specified sound source distance
-                        float amplitude = sqrt(
-                                               (fftSignalFrequencyDomain_[i][0] *
-                                                fftSignalFrequencyDomain_[i][0]) +
-                                               (fftSignalFrequencyDomain_[i][1] *
-                                                 fftSignalFrequencyDomain_[i][1])) *
-                                                1/distance;
-
-                        // If user has selected pass-through, recover original phase information
-                        if (passthrough)
-                        {
-                            phase = atan2(fftSignalFrequencyDomain_[i][1], fftSignalFrequencyDomain_[i][0]);
-                        }
-                        // If user has selected the robotisation effect, set phase value to 0.0
-                        else if (robotisation)
-                        {
-                            phase = 0.0;
-                        }
-                        // If user has selected the whisperisation effect, replace the phase value with a random number between 0-2π
-                        else if (whisperisation)
-                        {
-                            phase = 2.0 * M_PI * (float)rand() / (float)RAND_MAX;
-                        }
-
-                        // F(k)
-                        fftSignalFrequencyDomain_[i][0] = amplitude * cos(phase);
-                        fftSignalFrequencyDomain_[i][1] = amplitude * sin(phase);
-
-                        // F(N-k)
-                        if (i != 0)
-                        {
-                            fftSignalFrequencyDomain_[fftActualTransformSize_ - i][0] = amplitude * cos(phase);
-                            fftSignalFrequencyDomain_[fftActualTransformSize_ - i][1] = -amplitude * sin(phase);
-                        }
-                    }
-
-                    //Perform IFFT on augmented amplitude and phase information inside fftSignalFrequencyDomain_, outputting fftSignalTimeDomain_
-                    fftw_execute(fftwSignalBackwardPlan_);
-
-                    // Add the result to the output buffer, starting at the outputBufferIndex which is assigned according to the write position in outputBufferData
-                    int outputBufferIndex = outwritepos;
-                    for (int fftBufferIndex = 0; fftBufferIndex < fftActualTransformSize_; fftBufferIndex++)
-                    {
-                        // Inside outputBufferData accumulate each sample in the real dimension of fftSignalTimeDomain_, multiplied by the scale factor (in our case 1/K)
-                        outputBufferData[outputBufferIndex] += fftSignalTimeDomain_[fftBufferIndex][0] * fftSignalScaleFactor_;
-                        if (++outputBufferIndex >= outputBufferLength_)
-                        {
-                            outputBufferIndex = 0;
-                        }
-                    }
-                    // Advance the write position in the output buffer by the hopsize
-                    outwritepos = (outwritepos + hopActualSize_) % outputBufferLength_;
-                }
-            }
-
-            // Update previously cached state variables
-            inputBufferWritePosition_ = inwritepos;
-            outputBufferWritePosition_ = outwritepos;
-            outputBufferReadPosition_ = outreadpos;
-            samplesSinceLastFFT_ = sampssincefft;
-            
-            // Load impulse response numbers stored a global variables LL, UL, LR and UR inside the ImpulseSelectionStateMachine class as parameters into the impulseResponseCrossfade object of type IRCrossfade
-            impulseResponseCrossfade.loadImpulses(channel, irBank.bufferArray[impulseStateMachine.LL], irBank.bufferArray[impulseStateMachine.UL], irBank.bufferArray[impulseStateMachine.LR], irBank.bufferArray[impulseStateMachine.UR]);
-            //Perform FFT, complex multiplication and IFFTs on the 4 impulse responses
-            impulseResponseCrossfade.impulseFFTBlend();
-            impulseResponseCrossfade.backwardFFTandStore(channel, totalNumInputChannels);
-
+            if (const HRTFFilter* filter = hrtfFilterSwap.acquire())
+                loadHRTF(*filter);
         }
 
-        //Interaural delay
-        // Attain writable pointers for each channel to the buffer, processBuffer and delayBuffer_
-        float* LchannelData = buffer.getWritePointer(0);
-        float* RchannelData = buffer.getWritePointer(1);
-        float* LprocessData = processBuffer.getWritePointer(0);
-        float* RprocessData = processBuffer.getWritePointer(1);
-        float* LdelayData = delayBuffer_.getWritePointer(0);
-        float* RdelayData = delayBuffer_.getWritePointer(1);
-
-        // Depedent on which quadrant the virtual sound source is in, either of the listener's ears may be the 'leading ear', so azimuth-dependent delays are calculated accordingly for each situation
-        // Sound source is in quadrant 1
-        if (azimuth > 0 && azimuth < M_PI/2)
-        {
-            Ldelay_ = 0.07*(abs(rad2deg(azimuth)) + 1 - M_PI/2)/c_;
-            Rdelay_ = 0.07*(1-cos(rad2deg(azimuth)))/c_;
-        }
-        // Sound source is in quadrant 2
-        else if (azimuth > -M_PI/2 && azimuth < 0)
-        {
-            Ldelay_ = 0.07*(1-cos(rad2deg(azimuth)))/c_;
-            Rdelay_ = 0.07*(abs(rad2deg(azimuth)) + 1 - M_PI/2)/c_;
-        }
-        // Sound source is in quadrant 3
-        else if (azimuth < -M_PI/2 && azimuth > -M_PI)
-        {
-            Ldelay_ = 0.07*(1-cos(rad2deg(azimuth)))/c_;
-            Rdelay_ = 0.07*(abs(rad2deg(azimuth + M_PI)) + 1 - M_PI/2)/c_;
-        }
-        // Sound source is in quadrant 4
-        else if (azimuth > M_PI/2 && azimuth < M_PI)
-        {
-            Ldelay_ = 0.07*(abs(rad2deg(azimuth - M_PI)) + 1 - M_PI/2)/c_;
-            Rdelay_ = 0.07*(1-cos(rad2deg(azimuth)))/c_;
-        }
-        // Sound source is directly in front or behind
-        else if (azimuth == 0.0 || azimuth == -M_PI)
-        {
-            Ldelay_ = 0.0;
-            Rdelay_ = 0.0;
-        }
-        // Sanity check incase GUI sends unstable values
-        else if (azimuth < -M_PI || azimuth > M_PI)
-        {
-            azimuth = 0.0;
-        }
+        // Phase vocoder: the STFT engine replaces the contents of buffer in place with the resynthesised (delayed) signal, calling processSpectrum for every frame
+        // Pass-through only scales each bin by 1/distance, so its FFT/IFFT round trip is skipped in favour of the same latency-matched delay and gain. When the HRTF is
+        // fused, only the zero-padded transforms that apply it are kept
+        if (passthrough && fusedHRTFActive_ == false)
+            stftEngine.processDelay(buffer, numSamples, 1.0/distance);
+        else if (passthrough)
+            stftEngine.processFiltered(buffer, numSamples, 1.0/distance, *this);
+        else
+            stftEngine.process(buffer, numSamples, *this);
 
-        // Each ear's read position in its respective delay buffer is calculated dependent on the delay times calculated above
-        leftEarDelayPosition_ = (int)(delayWritePosition_ - ((Ldelay_*0.01) * sampleRate) + delayBufferLength_) % delayBufferLength_;
-        rightEarDelayPosition_ = (int)(delayWritePosition_ - ((Rdelay_*0.01) * sampleRate) + delayBufferLength_) % delayBufferLength_;
-
-        // Similar to the phase vocoder arcitecture, state counters are cached so each channel can have independent behaviour
-        dwp = delayWritePosition_;
-        lrp = leftEarDelayPosition_;
-        rrp = rightEarDelayPosition_;
-
-        // Iterate through the buffer, storing samples from processBuffer into the delay buffers. The read each delay buffer at their own read pointer into the respective channels of the main buffer
-        for (int i = 0; i < bufferSize; i++)
-        {
-            LdelayData[dwp] = LprocessData[i];
-            RdelayData[dwp] = RprocessData[i];
-
-            LchannelData[i] = LdelayData[lrp] * 2.0 * audioGain;
-            RchannelData[i] = RdelayData[rrp] * 2.0 * audioGain;
-
-            // Ensure pointers stay in range
-            if (++lrp >= delayBufferLength_)
-                lrp = 0;
-            if (++rrp >= delayBufferLength_)
-                rrp = 0;
-            if (++dwp >= delayBufferLength_)
-                dwp = 0;
-        }
-        // Update previously cached pointer state variables
-        delayWritePosition_ = dwp;
-        leftEarDelayPosition_ = lrp;
-        rightEarDelayPosition_ = rrp;
-        
-        BinaryData::IR_wavSize;
-    
+        //Interaural delay
+        // Either of the listener's ears may be the 'leading ear', depending on the side the virtual sound source is on. Each ear's delay is looked up for the source
+        // direction and set on top of the interpolator's minimum. The delay lines glide to it over this block, sample by sample, and run in place on the main buffer
+        double leftEarDelay, rightEarDelay;
+        itdTable_.getDelays(azimuth, elevation, leftEarDelay, rightEarDelay);
+        interauralDelay_.setDelay(0, FRACTIONAL_DELAY_MIN_SAMPLES + leftEarDelay);
+        interauralDelay_.setDelay(1, FRACTIONAL_DELAY_MIN_SAMPLES + rightEarDelay);
+        interauralDelay_.process(0, buffer.getWritePointer(0), numSamples, 2.0 * audioGain);
+        interauralDelay_.process(1, buffer.getWritePointer(1), numSamples, 2.0 * audioGain);
         
         //Convolution
-        // Load novel spectrally combined impulse response into juceConvolution object
-        juceConvolution.copyAndLoadImpulseResponseFromBuffer(impulseResponseCrossfade.crossfadedImpulse, sampleRate, true, false, true, 0);
-
-        // DSP audio block replaces buffer
-        dsp::AudioBlock<float> block (buffer);
-        dsp::ProcessContextReplacing<float> context (block);
-        
-        //Process
-        juceConvolution.process(context);
+        // The interaural delay and the HRTF are both linear and per ear, so applying the HRTF inside the vocoder (fused mode) instead of here gives the same result
+        if (fusedHRTFActive_ == false)
+        {
+            convolveHRTF(buffer, numSamples);
+        }
     }
 }
 
@@ -426,14 +347,59 @@ void DafxBinauralPhaseVocoderAudioProcessor::processBlock (AudioBuffer<float>& b
 */
 void DafxBinauralPhaseVocoderAudioProcessor::releaseResources()
 {
-    fftw_destroy_plan(fftwSignalForwardPlan_);
-    fftw_destroy_plan(fftwSignalBackwardPlan_);
-    fftw_free(fftSignalTimeDomain_);
-    fftw_free(fftSignalFrequencyDomain_);
+    stftEngine.release();
+    hrtfSpectralFilter.release();
+    hrtfPartitionedConvolver.release();
+    hrtfHybridConvolver.release();
     
-    free(windowBuffer_);
-    windowBuffer_ = 0;
-    windowBufferLength_ = 0;
+    // Stop the dense grid's background build and free its filters. updateHRTF only reads the grid under the producer lock, so holding it here makes that safe
+    const ScopedLock producerLock (hrtfProducerLock_);
+    hrtfDenseGrid_.release();
+}
+
+/*
+  * @brief Whether the HRTF stage in use (the spectral filter in fused mode, otherwise the chosen convolver) is still fading out its previous filter
+*/
+bool DafxBinauralPhaseVocoderAudioProcessor::isHRTFCrossfading() const
+{
+    if (fusedHRTFActive_)
+        return hrtfSpectralFilter.isCrossfading();
+    if (hrtfConvolverActive_ == HRTFConvolverSelector::partitionedConvolver)
+        return hrtfPartitionedConvolver.isCrossfading();
+    if (hrtfConvolverActive_ == HRTFConvolverSelector::hybridConvolver)
+        return hrtfHybridConvolver.isCrossfading();
+    return hrtfConvolver.isCrossfading();
+}
+
+/*
+  * @brief Start crossfading the HRTF stage in use to a new filter
+  * @param Per-ear filter, as acquired from hrtfFilterSwap
+*/
+void DafxBinauralPhaseVocoderAudioProcessor::loadHRTF(const HRTFFilter& filter)
+{
+    if (fusedHRTFActive_)
+        hrtfSpectralFilter.loadFilter(filter);
+    else if (hrtfConvolverActive_ == HRTFConvolverSelector::partitionedConvolver)
+        hrtfPartitionedConvolver.loadFilter(filter);
+    else if (hrtfConvolverActive_ == HRTFConvolverSelector::hybridConvolver)
+        hrtfHybridConvolver.loadFilter(filter);
+    else
+        hrtfConvolver.loadFilter(filter);
+}
+
+/*
+  * @brief Convolve the buffer in place with the chosen convolver, when the HRTF is not fused into the vocoder
+  * @param Buffer with one channel per ear
+  * @param Number of samples to process
+*/
+void DafxBinauralPhaseVocoderAudioProcessor::convolveHRTF(AudioSampleBuffer& buffer, int numSamples)
+{
+    if (hrtfConvolverActive_ == HRTFConvolverSelector::partitionedConvolver)
+        hrtfPartitionedConvolver.process(buffer, numSamples);
+    else if (hrtfConvolverActive_ == HRTFConvolverSelector::hybridConvolver)
+        hrtfHybridConvolver.process(buffer, numSamples);
+    else
+        hrtfConvolver.process(buffer, numSamples);
 }
 
 //==============================================================================
@@ -469,9 +435,18 @@ bool DafxBinauralPhaseVocoderAudioProcessor::isMidiEffect() const
    #endif
 }
 
+/*
+  * @brief Time the output carries on for once the input stops, on top of the latency reported to the host: the rest of the last vocoder frame, the HRTF, the largest
+  * interaural delay and the reverb. Hosts may only ask once, so this is the worst case whatever the reverb's current settings
+*/
 double DafxBinauralPhaseVocoderAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    const double currentSampleRate = getSampleRate();
+    if (currentSampleRate <= 0.0)
+        return 0.0;
+    
+    const double filterTail = (stftEngine.getTransformSize() + HRIR_SIZE - 1) / currentSampleRate + ITD_MAX_SECONDS;
+    return filterTail + REVERB_TAIL_SECONDS;
 }
 
 int DafxBinauralPhaseVocoderAudioProcessor::getNumPrograms()
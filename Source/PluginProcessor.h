@@ -11,17 +11,36 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include <api/fftw3.h>
+#include "SpectralTypes.h"
 #include "IRBank.h"
 #include "Util.h"
 #include "IRCrossfade.h"
 #include <cmath>
-#include "StateMachine.h"
+#include <atomic>
+#include "HRIRGrid.h"
+#include "HRTFDenseGrid.h"
+#include "HRTFFilterCache.h"
+#include "HRTFFilterSwap.h"
+#include "HRTFConvolver.h"
+#include "HRTFPartitionedConvolver.h"
+#include "HRTFConvolverSelector.h"
+#include "HRTFSpectralFilter.h"
+#include "SourcePositionTracker.h"
+#include "FractionalDelayLine.h"
+#include "ITDTable.h"
+#include "STFTEngine.h"
+#include "VocoderKernels.h"
+#include "RandomPhaseGenerator.h"
+#include "AudioThreadGuard.h"
+
+// Time the reverb (at the fixed room size and damping) takes to decay by 60 dB
+#define REVERB_TAIL_SECONDS 1.5
 
 //==============================================================================
 /**
 */
 class DafxBinauralPhaseVocoderAudioProcessor  : public AudioProcessor
+    , public STFTEngine::SpectrumProcessor
 {
 public:
     //==============================================================================
@@ -52,24 +71,39 @@ public:
     void getStateInformation (MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
     
-    //dsp::Convolution
-    dsp::Convolution juceConvolution;
+    //Convolution
+    HRTFConvolver hrtfConvolver;
+    HRTFPartitionedConvolver hrtfPartitionedConvolver;
+    HRTFHybridConvolver hrtfHybridConvolver;
+    int hrtfConvolverMode;    // HRTFConvolverSelector mode: automatic, direct FIR, partitioned FFT or zero-latency hybrid, taking effect on the next call to prepareToPlay
+    HRTFSpectralFilter hrtfSpectralFilter;
+    bool fusedHRTF;    // Apply the HRTF inside the phase vocoder, taking effect on the next call to prepareToPlay
+    HRTFFilterSwap hrtfFilterSwap;
     IRBank irBank;
     IRCrossfade impulseResponseCrossfade;
+    HRTFFilterCache hrtfFilterCache;    // Blended HRTFs of recently visited directions, with hit/miss counters
+    bool denseHRTFGrid;    // Synthesise the HRTF for a dense grid of directions in the background (about 13.6 MB), taking effect on the next call to prepareToPlay. Without it,
+                           // only the fixed-size cache holds synthesised HRTFs, so memory per instance stays bounded
     AudioSampleBuffer crossfadedImpulse;
+    void updateHRTF();
+    void setHRTFThreshold(double degrees);
     
     //Gain
     void setGain(float gainSend);
     
     //FFT
-    void initFFT(int FFTLength);
-    float phase;
+    void setSTFTConfiguration(int fftSize, int hopDivisor, int windowType);
+    void processSpectrum(SpectralComplex* spectrum, int numBins, int channel) override;
+    void filterSpectrum(SpectralComplex* spectrum, int numBins, int channel) override;
+    STFTEngine stftEngine;
+    int vocoderAccuracy;
     
     //Buttons
     bool bypass;
     bool passthrough;
     bool robotisation;
     bool whisperisation;
+    uint64_t whisperSeed;
     
     //General global variables
     int numberofChannels;
@@ -81,7 +115,7 @@ public:
     double azimuth;
     int elevation;
     float distance;
-    ImpulseSelectionStateMachine impulseSelectionStateMachine;
+    HRIRGrid hrirGrid;
     bool hasRun;
     
     Reverb reverb;
@@ -91,42 +125,31 @@ private:
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DafxBinauralPhaseVocoderAudioProcessor)
 
-    //FFTW
-    fftw_complex *fftSignalTimeDomain_,
-    *fftSignalFrequencyDomain_;
-    fftw_plan fftwSignalForwardPlan_,
-    fftwSignalBackwardPlan_;
-
-    // Overlap-add architecture
-    int fftActualTransformSize_;
-    int hopActualSize_;
-    double fftSignalScaleFactor_;
-    AudioBuffer<float> inputBuffer_;
-    int inputBufferLength_;
-    int inputBufferWritePosition_;
-
-    bool fftInitialised_;
-    bool preparedToPlay_;
-    AudioBuffer<float> outputBuffer_;
-    int outputBufferLength_;
-    int outputBufferReadPosition_, outputBufferWritePosition_;
-
-    int samplesSinceLastFFT_;
-    double *windowBuffer_;
-    int windowBufferLength_;
-    int hopSelectedSize_;
-    int windowType_;
+    std::atomic<bool> preparedToPlay_;
+    // The filter swap takes one producer at a time, and updateHRTF is called from prepareToPlay (on whatever thread the host prepares on) as well as from the editor.
+    // Held for as long as either touches the HRIR bank, the blend scratch, the filter cache, the position tracker or the write side of the swap
+    CriticalSection hrtfProducerLock_;
     
     //ITD
-    AudioSampleBuffer delayBuffer_;
-    int delayBufferLength_;
-    int leftEarDelayPosition_;
-    int rightEarDelayPosition_;
-    int delayWritePosition_;
+    // Each ear's delay, interpolated between samples and glided across every block so that a moving source never makes the read position jump
+    FractionalDelayLine interauralDelay_;
+    // Each ear's delay for every direction, from the spherical-head model at the host sample rate
+    ITDTable itdTable_;
+    
+    //HRTF synthesis
+    SourcePositionTracker hrtfPosition_;
+    // Declared after irBank and hrirGrid, which its background thread reads, so that it is destroyed (and the thread stopped) before them
+    HRTFDenseGrid hrtfDenseGrid_;
+    bool fusedHRTFActive_;
+    int hrtfConvolverActive_;    // HRTFConvolverSelector choice of convolver in use when the HRTF is not fused
+    bool isHRTFCrossfading() const;
+    void loadHRTF(const HRTFFilter& filter);
+    void convolveHRTF(AudioSampleBuffer& buffer, int numSamples);
     
-    float Ldelay_;
-    float Rdelay_;
-    float c_;
+    //Whisperisation
+    RandomPhaseGenerator randomPhaseGenerators_[STFT_MAX_CHANNELS];
+    SpectralSample randomPhases_[STFT_MAX_FFT_SIZE/2 + 1];
+    SpectralComplex randomPhasors_[STFT_MAX_FFT_SIZE/2 + 1];
     
 //    AudioFormatReaderSource* source = nullptr;
 };
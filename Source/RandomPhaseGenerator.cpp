@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "RandomPhaseGenerator.h"
+#include <cmath>
+#include <cstring>
+
+// Unit phasors e^(j2πk/T) for k = 0 to T - 1, shared by every instance. Built once on first use, and read-only afterwards
+struct RandomPhasorTable
+{
+    RandomPhasorTable()
+    {
+        for (int k = 0; k < RANDOM_PHASOR_TABLE_SIZE; ++k)
+        {
+            phasors[k][0] = cos(2.0 * M_PI * k / RANDOM_PHASOR_TABLE_SIZE);
+            phasors[k][1] = sin(2.0 * M_PI * k / RANDOM_PHASOR_TABLE_SIZE);
+        }
+    }
+
+    SpectralSample phasors[RANDOM_PHASOR_TABLE_SIZE][2];
+};
+
+static const RandomPhasorTable& getRandomPhasorTable()
+{
+    static const RandomPhasorTable table;
+    return table;
+}
+
+static inline uint64_t splitMix64(uint64_t& x)
+{
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+RandomPhaseGenerator::RandomPhaseGenerator()
+{
+    getRandomPhasorTable();
+    setSeed(0);
+}
+
+/*
+  * @brief Restart the generator from a seed, so the same seed always gives the same sequence of phases
+  * @param Seed
+*/
+void RandomPhaseGenerator::setSeed(uint64_t seed)
+{
+    // Expand the seed into the state of every lane with SplitMix64, as recommended for xoshiro, which also guarantees the state is never all zero
+    for (int lane = 0; lane < RANDOM_PHASE_LANES; ++lane)
+    {
+        for (int word = 0; word < 4; ++word)
+        {
+            state_[word][lane] = splitMix64(seed);
+        }
+    }
+}
+
+/*
+  * @brief Advance every lane by one step of xoshiro256+
+  * @param Array of RANDOM_PHASE_LANES outputs, whose top 53 bits are uniformly distributed
+*/
+void RandomPhaseGenerator::step(uint64_t* output)
+{
+    // Each statement is one operation across all lanes, which the compiler turns into SIMD instructions
+    for (int lane = 0; lane < RANDOM_PHASE_LANES; ++lane)
+    {
+        output[lane] = state_[0][lane] + state_[3][lane];
+
+        const uint64_t t = state_[1][lane] << 17;
+        state_[2][lane] ^= state_[0][lane];
+        state_[3][lane] ^= state_[1][lane];
+        state_[1][lane] ^= state_[2][lane];
+        state_[0][lane] ^= state_[3][lane];
+        state_[2][lane] ^= t;
+        state_[3][lane] = (state_[3][lane] << 45) | (state_[3][lane] >> 19);
+    }
+}
+
+/*
+  * @brief Fill an array with uniformly distributed random phases
+  * @param Output phases, in radians between 0 and 2π
+  * @param Number of phases
+*/
+void RandomPhaseGenerator::fillPhases(SpectralSample* phases, int numPhases)
+{
+    uint64_t output[RANDOM_PHASE_LANES];
+
+    for (int i = 0; i < numPhases; i += RANDOM_PHASE_LANES)
+    {
+        step(output);
+
+        // Placing the top bits under the exponent of 1.0 gives a number in [1, 2) without an integer to floating point conversion
+        SpectralSample unit[RANDOM_PHASE_LANES];
+        for (int lane = 0; lane < RANDOM_PHASE_LANES; ++lane)
+        {
+#if BPV_DOUBLE_PRECISION
+            const uint64_t bits = (output[lane] >> 12) | 0x3ff0000000000000ULL;
+#else
+            const uint32_t bits = (uint32_t)(output[lane] >> 41) | 0x3f800000U;
+#endif
+            std::memcpy(&unit[lane], &bits, sizeof(SpectralSample));
+        }
+
+        const int count = jmin(RANDOM_PHASE_LANES, numPhases - i);
+        for (int lane = 0; lane < count; ++lane)
+        {
+            phases[i + lane] = (SpectralSample)(2.0 * M_PI) * (unit[lane] - 1);
+        }
+    }
+}
+
+/*
+  * @brief Fill an array with unit phasors of uniformly distributed random phase, quantised to 2π/RANDOM_PHASOR_TABLE_SIZE, which avoids evaluating cos and sin
+  * @param Output phasors (cos, sin)
+  * @param Number of phasors
+*/
+void RandomPhaseGenerator::fillPhasors(SpectralComplex* phasors, int numPhasors)
+{
+    const RandomPhasorTable& table = getRandomPhasorTable();
+    uint64_t output[RANDOM_PHASE_LANES];
+
+    for (int i = 0; i < numPhasors; i += RANDOM_PHASE_LANES)
+    {
+        step(output);
+
+        const int count = jmin(RANDOM_PHASE_LANES, numPhasors - i);
+        for (int lane = 0; lane < count; ++lane)
+        {
+            // The top bits of xoshiro256+ are its best, so the table index is taken from them
+            const int index = (int)(output[lane] >> (64 - RANDOM_PHASOR_TABLE_BITS));
+            phasors[i + lane][0] = table.phasors[index][0];
+            phasors[i + lane][1] = table.phasors[index][1];
+        }
+    }
+}
+
+RandomPhaseGenerator::~RandomPhaseGenerator()
+{
+}
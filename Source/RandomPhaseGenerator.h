@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralTypes.h"
+#include <cstdint>
+
+#define RANDOM_PHASE_LANES 4
+#define RANDOM_PHASOR_TABLE_BITS 10
+#define RANDOM_PHASOR_TABLE_SIZE (1 << RANDOM_PHASOR_TABLE_BITS)
+
+class RandomPhaseGenerator
+{
+public:
+    RandomPhaseGenerator();
+    ~RandomPhaseGenerator();
+
+    void setSeed(uint64_t seed);
+    void fillPhases(SpectralSample* phases, int numPhases);
+    void fillPhasors(SpectralComplex* phasors, int numPhasors);
+
+private:
+    void step(uint64_t* output);
+
+    // RANDOM_PHASE_LANES independent xoshiro256+ generators, stored word by word so that one step of every lane is a handful of vector operations
+    uint64_t state_[4][RANDOM_PHASE_LANES];
+
+    JUCE_DECLARE_NON_COPYABLE (RandomPhaseGenerator)
+};
@@ -0,0 +1,489 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "STFTEngine.h"
+
+STFTEngine::STFTEngine()
+{
+    // Default configuration: 512-point FFT, no overlap and a rectangular window
+    fftSize_ = 512;
+    hopDivisor_ = 1;
+    windowType_ = rectangularWindow;
+    filterLength_ = 1;
+
+    frameActualSize_ = fftSize_;
+    fftActualTransformSize_ = fftSize_;
+    hopActualSize_ = fftSize_;
+    numBins_ = fftSize_/2 + 1;
+    fftSignalScaleFactor_ = 0.0;
+    numChannels_ = 0;
+    maximumBlockSize_ = 0;
+    prepared_ = false;
+    configurationChanged_ = true;
+
+    maxFramesPerBlock_ = 0;
+    analysisWindow_ = nullptr;
+    synthesisWindow_ = nullptr;
+    inputBufferLength_ = outputBufferLength_ = 1;
+    inputBufferMask_ = outputBufferMask_ = 0;
+}
+
+/*
+  * @brief Choose the FFT size, overlap and window. Takes effect the next time prepare is called
+  * @param FFT size, rounded up to a power of 2 between STFT_MIN_FFT_SIZE and STFT_MAX_FFT_SIZE
+  * @param Hop size as a fraction of the FFT size: 1 (no overlap), 2 (1/2) or 4 (1/4)
+  * @param Window type (rectangularWindow, hannWindow or sqrtHannWindow). The Hann windows only overlap-add to a constant with a hop of 1/2 or 1/4
+*/
+void STFTEngine::setConfiguration(int fftSize, int hopDivisor, int windowType)
+{
+    const int newFFTSize = nextPowerOf2(jlimit(STFT_MIN_FFT_SIZE, STFT_MAX_FFT_SIZE, fftSize));
+    const int newHopDivisor = hopDivisor >= 4 ? 4 : (hopDivisor >= 2 ? 2 : 1);
+    const int newWindowType = jlimit((int)rectangularWindow, (int)sqrtHannWindow, windowType);
+
+    if (newFFTSize != fftSize_ || newHopDivisor != hopDivisor_ || newWindowType != windowType_)
+    {
+        fftSize_ = newFFTSize;
+        hopDivisor_ = newHopDivisor;
+        windowType_ = newWindowType;
+        configurationChanged_ = true;
+    }
+}
+
+/*
+  * @brief Zero-pad every frame so that a filter of up to this many taps can be applied by multiplying the spectrum, without circular aliasing. The transform size
+  * becomes the next power of 2 of (FFT size + filter length - 1), and each processed frame is overlap-added in full. Takes effect the next time prepare is called
+  * @param Filter length in samples, or 1 for no padding
+*/
+void STFTEngine::setFilterLength(int filterLength)
+{
+    filterLength = jmax(1, filterLength);
+
+    if (filterLength != filterLength_)
+    {
+        filterLength_ = filterLength;
+        configurationChanged_ = true;
+    }
+}
+
+/*
+  * @brief Allocate buffers, create FFTW plans and build the windows for the current configuration. If none of these has changed since the last call, the existing plans are kept and only the buffers are cleared
+  * @param Number of channels that will be processed
+  * @param Largest number of samples that will be passed to process at once
+*/
+void STFTEngine::prepare(int numChannels, int maximumBlockSize)
+{
+    numChannels = jlimit(1, STFT_MAX_CHANNELS, numChannels);
+    maximumBlockSize = jmax(1, maximumBlockSize);
+
+    if (prepared_ && configurationChanged_ == false && numChannels == numChannels_ && maximumBlockSize == maximumBlockSize_)
+    {
+        reset();
+        return;
+    }
+
+    release();
+
+    frameActualSize_ = fftSize_;
+    fftActualTransformSize_ = filterLength_ > 1 ? nextPowerOf2(fftSize_ + filterLength_ - 1) : fftSize_;
+    hopActualSize_ = fftSize_ / hopDivisor_;
+    numChannels_ = numChannels;
+    maximumBlockSize_ = maximumBlockSize;
+
+    // The input is purely real, so its spectrum is conjugate symmetric and only the first N/2 + 1 bins are processed
+    numBins_ = frameActualSize_/2 + 1;
+
+    // A block of B samples completes at most B/hop + 1 frames on each channel. The frames of every channel share one batch, which is planned (and measured, overwriting
+    // the batch arrays) before anything is stored in it. Any number of frames up to the most a block can complete is transformed in one call per set bit
+    maxFramesPerBlock_ = maximumBlockSize_ / hopActualSize_ + 1;
+    fftBatch_.prepare(frameActualSize_, numChannels_ * maxFramesPerBlock_, FFTBatch::bothDirections, true);
+    maxFramesPerBlock_ = fftBatch_.getNumTransforms() / numChannels_;
+
+    // The zero-padded frames for filtering get a second batch of the same number of longer transforms
+    if (fftActualTransformSize_ != frameActualSize_)
+        filterBatch_.prepare(fftActualTransformSize_, numChannels_ * maxFramesPerBlock_, FFTBatch::bothDirections, true);
+
+    analysisWindow_ = (SpectralSample *)malloc(frameActualSize_ * sizeof(SpectralSample));
+    synthesisWindow_ = (SpectralSample *)malloc(frameActualSize_ * sizeof(SpectralSample));
+    buildWindows();
+
+    // Size the circular buffers used to store samples in intermediate stages of the phase vocoder. Each must hold a whole block plus one frame (a whole transform for the output)
+    inputBufferLength_ = nextPowerOf2(maximumBlockSize_ + frameActualSize_);
+    inputBufferMask_ = inputBufferLength_ - 1;
+    inputBuffer_.setSize(numChannels_, inputBufferLength_);
+    outputBufferLength_ = nextPowerOf2(maximumBlockSize_ + fftActualTransformSize_);
+    outputBufferMask_ = outputBufferLength_ - 1;
+    outputBuffer_.setSize(numChannels_, outputBufferLength_);
+
+    configurationChanged_ = false;
+    prepared_ = true;
+    reset();
+}
+
+/*
+  * @brief Clear the circular buffers and return to the state at the start of a stream
+*/
+void STFTEngine::reset()
+{
+    inputBuffer_.clear();
+    outputBuffer_.clear();
+
+    // Initialise counters and read pointers. A frame is taken every hop and covers the last N samples, so writing it one hop ahead of the read pointer makes the latency exactly one frame length
+    for (int channel = 0; channel < STFT_MAX_CHANNELS; ++channel)
+    {
+        inputBufferWritePosition_[channel] = 0;
+        outputBufferReadPosition_[channel] = 0;
+        outputBufferWritePosition_[channel] = hopActualSize_;
+        samplesSinceLastFFT_[channel] = 0;
+    }
+}
+
+/*
+  * @brief Fill the analysis and synthesis windows, and fold the COLA gain of the pair into the IFFT scale factor. The synthesis window tapers the N-point frame whether
+  * or not it is filtered afterwards, as the vocoder effects spread each frame over its whole length
+*/
+void STFTEngine::buildWindows()
+{
+    for (int n = 0; n < frameActualSize_; n++)
+    {
+        // Periodic Hann window, which sums to a constant when overlapped at 1/2 or 1/4 of its length
+        const double hann = 0.5 * (1.0 - cos(2.0 * M_PI * n / frameActualSize_));
+
+        if (windowType_ == hannWindow)
+        {
+            // Hann analysis window, and no synthesis window
+            analysisWindow_[n] = hann;
+            synthesisWindow_[n] = 1.0;
+        }
+        else if (windowType_ == sqrtHannWindow)
+        {
+            // Split the Hann window between analysis and synthesis so that both ends are tapered
+            analysisWindow_[n] = sqrt(hann);
+            synthesisWindow_[n] = sqrt(hann);
+        }
+        else
+        {
+            analysisWindow_[n] = 1.0;
+            synthesisWindow_[n] = 1.0;
+        }
+    }
+
+    // Overlapping analysis * synthesis windows at the hop size sum to (sum of the window product) / hop at every sample, so dividing by that makes the overlap-add unity gain. FFTW's IFFT is unnormalised, so the 1/N is applied here too
+    double windowSum = 0.0;
+    for (int n = 0; n < frameActualSize_; n++)
+    {
+        windowSum += analysisWindow_[n] * synthesisWindow_[n];
+    }
+    const double colaGain = windowSum / hopActualSize_;
+    fftSignalScaleFactor_ = 1.0 / (frameActualSize_ * colaGain);
+
+    // The scale factor is folded into the synthesis window so the overlap-add is a single multiply-accumulate
+    for (int n = 0; n < frameActualSize_; n++)
+    {
+        synthesisWindow_[n] *= fftSignalScaleFactor_;
+    }
+}
+
+/*
+  * @brief Free up memory upon termination of audio processing
+*/
+void STFTEngine::release()
+{
+    if (prepared_ == false)
+        return;
+
+    fftBatch_.release();
+    filterBatch_.release();
+
+    free(analysisWindow_);
+    free(synthesisWindow_);
+    analysisWindow_ = nullptr;
+    synthesisWindow_ = nullptr;
+
+    prepared_ = false;
+}
+
+/*
+  * @brief Run the short-time Fourier transform over a block of samples in place, passing the spectrum of each frame to the spectrum processor
+  * @param Audio buffer, replaced with the processed (delayed) output
+  * @param Number of samples in the block
+  * @param Object that modifies the spectrum of each frame
+*/
+void STFTEngine::process(AudioSampleBuffer& buffer, int numSamples, SpectrumProcessor& spectrumProcessor)
+{
+    if (prepared_ == false)
+        return;
+
+    // Blocks larger than the one prepared for are split, so the circular buffers and batch never overflow
+    for (int start = 0; start < numSamples; start += maximumBlockSize_)
+    {
+        processChunk(buffer, start, jmin(maximumBlockSize_, numSamples - start), &spectrumProcessor, true, 1.0);
+    }
+}
+
+/*
+  * @brief Equivalent of process with a spectrum processor that only scales every bin, i.e. the pass-through vocoder, and does not filter. The FFT and IFFT cancel out, so they are skipped and each windowed frame is overlap-added directly.
+  * The circular buffers carry on exactly as in process, so the two can be switched between at any block without a discontinuity, and the latency is the same
+  * @param Audio buffer, replaced with the delayed output
+  * @param Number of samples in the block
+  * @param Gain applied to each frame
+*/
+void STFTEngine::processDelay(AudioSampleBuffer& buffer, int numSamples, double gain)
+{
+    if (prepared_ == false)
+        return;
+
+    for (int start = 0; start < numSamples; start += maximumBlockSize_)
+    {
+        processChunk(buffer, start, jmin(maximumBlockSize_, numSamples - start), nullptr, false, gain);
+    }
+}
+
+/*
+  * @brief Equivalent of process with a spectrum processor whose processSpectrum only scales every bin, when a filter length is set. The N-point FFT and IFFT cancel out,
+  * so each windowed frame is scaled and goes straight on to the zero-padded transform for filterSpectrum. Without a filter length this is the same as processDelay
+  * @param Audio buffer, replaced with the filtered (delayed) output
+  * @param Number of samples in the block
+  * @param Gain applied to each frame
+  * @param Object that filters the spectrum of each zero-padded frame
+*/
+void STFTEngine::processFiltered(AudioSampleBuffer& buffer, int numSamples, double gain, SpectrumProcessor& spectrumProcessor)
+{
+    if (prepared_ == false)
+        return;
+
+    for (int start = 0; start < numSamples; start += maximumBlockSize_)
+    {
+        processChunk(buffer, start, jmin(maximumBlockSize_, numSamples - start), &spectrumProcessor, false, gain);
+    }
+}
+
+/*
+  * @brief Process up to maximumBlockSize_ samples: store the block, transform every frame it completes on every channel as one batch, overlap-add them and read the block back out
+  * @param Audio buffer
+  * @param First sample of the chunk
+  * @param Number of samples in the chunk
+  * @param Object that modifies (and, with a filter length, filters) the spectrum of each frame, or nullptr to skip the transforms and the filter
+  * @param Whether the N-point transforms and processSpectrum run, or are skipped in favour of the gain
+  * @param Gain applied to each frame when the N-point transforms are skipped
+*/
+void STFTEngine::processChunk(AudioSampleBuffer& buffer, int startSample, int numSamples, SpectrumProcessor* spectrumProcessor, bool transformFrames, double delayGain)
+{
+    const int numChannels = jmin(numChannels_, buffer.getNumChannels());
+    const int N = frameActualSize_;
+    const int K = fftActualTransformSize_;
+
+    // Each channel's frames take the next run of the batch
+    int firstFrame[STFT_MAX_CHANNELS];
+    int numFrames[STFT_MAX_CHANNELS];
+    int totalFrames = 0;
+
+    //Iterate through the input channels, storing the block and gathering the frames it completes
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const float* processData = buffer.getReadPointer(channel, startSample);
+        float* inputBufferData = inputBuffer_.getWritePointer(channel);
+        const int inwritepos = inputBufferWritePosition_[channel];
+
+        // Store the whole block in the input buffer, in at most two contiguous spans either side of the wrap point
+        const int inputSpan = jmin(numSamples, inputBufferLength_ - inwritepos);
+        FloatVectorOperations::copy(inputBufferData + inwritepos, processData, inputSpan);
+        FloatVectorOperations::copy(inputBufferData, processData + inputSpan, numSamples - inputSpan);
+
+        // Gather every frame that completes inside this block. The next frame completes once another (hop - samples since the last FFT) samples have arrived, and each one covers the N samples before that point
+        firstFrame[channel] = totalFrames;
+        numFrames[channel] = 0;
+        for (int frameEnd = hopActualSize_ - samplesSinceLastFFT_[channel]; frameEnd <= numSamples; frameEnd += hopActualSize_)
+        {
+            const int frameStart = (inwritepos + frameEnd - N) & inputBufferMask_;
+            const int frameSpan = jmin(N, inputBufferLength_ - frameStart);
+            SpectralSample* frame = fftBatch_.getTimeDomain(totalFrames);
+
+            // Multiply by the analysis window on the way into the batch
+            for (int n = 0; n < frameSpan; n++)
+            {
+                frame[n] = analysisWindow_[n] * inputBufferData[frameStart + n];
+            }
+            for (int n = frameSpan; n < N; n++)
+            {
+                frame[n] = analysisWindow_[n] * inputBufferData[n - frameSpan];
+            }
+            ++numFrames[channel];
+            ++totalFrames;
+        }
+        jassert(numFrames[channel] <= maxFramesPerBlock_);
+
+        inputBufferWritePosition_[channel] = (inwritepos + numSamples) & inputBufferMask_;
+        samplesSinceLastFFT_[channel] = (samplesSinceLastFFT_[channel] + numSamples) % hopActualSize_;
+    }
+
+    if (totalFrames > 0 && transformFrames == false)
+    {
+        // Without the transforms, the 1/N scale factor in the synthesis window has nothing to cancel, so N is applied along with the gain
+        FloatVectorOperations::multiply(fftBatch_.getTimeDomain(0), delayGain * N, totalFrames * N);
+    }
+    else if (totalFrames > 0)
+    {
+        // Forward FFT of every frame of every channel in one batch, then the spectrum processor, then the IFFT of every frame (the c2r plans overwrite their input, which is refilled every block)
+        fftBatch_.forward(totalFrames);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            for (int frame = 0; frame < numFrames[channel]; ++frame)
+            {
+                spectrumProcessor->processSpectrum(fftBatch_.getFrequencyDomain(firstFrame[channel] + frame), numBins_, channel);
+            }
+        }
+
+        fftBatch_.backward(totalFrames);
+    }
+
+    // Filtering: each resynthesised frame is multiplied by the synthesis window (and 1/K for the second IFFT), zero-padded and filtered by multiplying its K-point
+    // spectrum. The filter's tail lands in the padding, so the filtered frames overlap-add to the filtered output of the unfiltered engine
+    const bool filterFrames = filterBatch_.isPrepared() && spectrumProcessor != nullptr;
+    if (totalFrames > 0 && filterFrames)
+    {
+        const SpectralSample filterScale = (SpectralSample)(1.0 / K);
+
+        for (int frame = 0; frame < totalFrames; ++frame)
+        {
+            const SpectralSample* frameData = fftBatch_.getTimeDomain(frame);
+            SpectralSample* paddedData = filterBatch_.getTimeDomain(frame);
+
+            for (int n = 0; n < N; n++)
+            {
+                paddedData[n] = filterScale * synthesisWindow_[n] * frameData[n];
+            }
+            for (int n = N; n < K; n++)
+            {
+                paddedData[n] = 0.0;
+            }
+        }
+
+        filterBatch_.forward(totalFrames);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            for (int frame = 0; frame < numFrames[channel]; ++frame)
+            {
+                spectrumProcessor->filterSpectrum(filterBatch_.getFrequencyDomain(firstFrame[channel] + frame), filterBatch_.getNumBins(), channel);
+            }
+        }
+
+        filterBatch_.backward(totalFrames);
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* processData = buffer.getWritePointer(channel, startSample);
+        float* outputBufferData = outputBuffer_.getWritePointer(channel);
+        const int outreadpos = outputBufferReadPosition_[channel];
+        const int outwritepos = outputBufferWritePosition_[channel];
+
+        if (numFrames[channel] > 0)
+        {
+            // Overlap-add each frame into the output buffer one hop after the previous one, multiplied by the synthesis window (which includes the 1/N scale factor).
+            // Filtered frames are already windowed and scaled, and run on for the whole K samples
+            for (int frame = 0; frame < numFrames[channel]; ++frame)
+            {
+                const int frameStart = (outwritepos + frame * hopActualSize_) & outputBufferMask_;
+
+                if (filterFrames)
+                {
+                    const SpectralSample* paddedData = filterBatch_.getTimeDomain(firstFrame[channel] + frame);
+                    const int frameSpan = jmin(K, outputBufferLength_ - frameStart);
+
+                    for (int n = 0; n < frameSpan; n++)
+                    {
+                        outputBufferData[frameStart + n] += paddedData[n];
+                    }
+                    for (int n = frameSpan; n < K; n++)
+                    {
+                        outputBufferData[n - frameSpan] += paddedData[n];
+                    }
+                }
+                else
+                {
+                    const SpectralSample* frameData = fftBatch_.getTimeDomain(firstFrame[channel] + frame);
+                    const int frameSpan = jmin(N, outputBufferLength_ - frameStart);
+
+                    for (int n = 0; n < frameSpan; n++)
+                    {
+                        outputBufferData[frameStart + n] += synthesisWindow_[n] * frameData[n];
+                    }
+                    for (int n = frameSpan; n < N; n++)
+                    {
+                        outputBufferData[n - frameSpan] += synthesisWindow_[n] * frameData[n];
+                    }
+                }
+            }
+
+            outputBufferWritePosition_[channel] = (outwritepos + numFrames[channel] * hopActualSize_) & outputBufferMask_;
+        }
+
+        // Read the block out of the output buffer and clear what was read in preparation for the next overlap-add, again in at most two spans
+        const int outputSpan = jmin(numSamples, outputBufferLength_ - outreadpos);
+        FloatVectorOperations::copy(processData, outputBufferData + outreadpos, outputSpan);
+        FloatVectorOperations::copy(processData + outputSpan, outputBufferData, numSamples - outputSpan);
+        FloatVectorOperations::clear(outputBufferData + outreadpos, outputSpan);
+        FloatVectorOperations::clear(outputBufferData, numSamples - outputSpan);
+
+        outputBufferReadPosition_[channel] = (outreadpos + numSamples) & outputBufferMask_;
+    }
+}
+
+/*
+  * @brief Length of each analysis frame, as configured
+*/
+int STFTEngine::getFFTSize() const
+{
+    return frameActualSize_;
+}
+
+/*
+  * @brief Length of the transforms, which is longer than the frames when they are zero-padded for filtering
+*/
+int STFTEngine::getTransformSize() const
+{
+    return fftActualTransformSize_;
+}
+
+int STFTEngine::getHopSize() const
+{
+    return hopActualSize_;
+}
+
+/*
+  * @brief Number of bins passed to processSpectrum, N/2 + 1
+*/
+int STFTEngine::getNumBins() const
+{
+    return numBins_;
+}
+
+/*
+  * @brief Number of bins passed to filterSpectrum, K/2 + 1
+*/
+int STFTEngine::getFilterNumBins() const
+{
+    return fftActualTransformSize_/2 + 1;
+}
+
+/*
+  * @brief Delay between a sample entering process and the same sample leaving it, which is one FFT length
+*/
+int STFTEngine::getLatencySamples() const
+{
+    return frameActualSize_;
+}
+
+STFTEngine::~STFTEngine()
+{
+    release();
+}
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SpectralTypes.h"
+#include "FFTWPlanner.h"
+#include "FFTBatch.h"
+#include "Util.h"
+#include <cmath>
+
+#define STFT_MIN_FFT_SIZE 128
+#define STFT_MAX_FFT_SIZE 4096
+#define STFT_MAX_CHANNELS 2
+
+class STFTEngine
+{
+public:
+    enum WindowType
+    {
+        rectangularWindow = 0,
+        hannWindow,
+        sqrtHannWindow
+    };
+
+    // Implemented by whatever modifies the spectrum of each frame (i.e. the phase vocoder). processSpectrum gets the N-point spectrum of each frame, and, when a filter
+    // length has been set, filterSpectrum gets the zero-padded K-point spectrum of the same frame after resynthesis, for filtering by multiplication
+    class SpectrumProcessor
+    {
+    public:
+        virtual ~SpectrumProcessor() {}
+        virtual void processSpectrum(SpectralComplex* spectrum, int numBins, int channel) = 0;
+        virtual void filterSpectrum(SpectralComplex* spectrum, int numBins, int channel) {}
+    };
+
+    STFTEngine();
+    ~STFTEngine();
+
+    void setConfiguration(int fftSize, int hopDivisor, int windowType);
+    void setFilterLength(int filterLength);
+    void prepare(int numChannels, int maximumBlockSize);
+    void release();
+    void reset();
+    void process(AudioSampleBuffer& buffer, int numSamples, SpectrumProcessor& spectrumProcessor);
+    void processDelay(AudioSampleBuffer& buffer, int numSamples, double gain);
+    void processFiltered(AudioSampleBuffer& buffer, int numSamples, double gain, SpectrumProcessor& spectrumProcessor);
+
+    int getFFTSize() const;
+    int getTransformSize() const;
+    int getHopSize() const;
+    int getNumBins() const;
+    int getFilterNumBins() const;
+    int getLatencySamples() const;
+
+private:
+    void buildWindows();
+    void processChunk(AudioSampleBuffer& buffer, int startSample, int numSamples, SpectrumProcessor* spectrumProcessor, bool transformFrames, double delayGain);
+
+    // Requested configuration, applied in prepare
+    int fftSize_;
+    int hopDivisor_;
+    int windowType_;
+    int filterLength_;
+    bool configurationChanged_;
+
+    // Overlap-add architecture. Frames are N = frameActualSize_ samples long. When filtering is enabled, each resynthesised and synthesis-windowed frame is zero-padded
+    // up to the transform size K and filtered, so the filtered frames overlap-add to exactly the filtered output
+    int frameActualSize_;
+    int fftActualTransformSize_;
+    int hopActualSize_;
+    int numBins_;
+    double fftSignalScaleFactor_;
+    int numChannels_;
+    int maximumBlockSize_;
+    bool prepared_;
+
+    //FFTW
+    // Every frame that completes within one block, on every channel, is transformed in a single batch: at N points, then again at K points when filtering
+    FFTBatch fftBatch_;
+    FFTBatch filterBatch_;
+    int maxFramesPerBlock_;
+
+    // Analysis and synthesis windows
+    SpectralSample *analysisWindow_;
+    SpectralSample *synthesisWindow_;
+
+    // Circular buffers and their positions, kept separately for each channel so the channels have independent behaviour. Both lengths are powers of 2, so positions wrap with a mask
+    AudioBuffer<float> inputBuffer_;
+    int inputBufferLength_;
+    int inputBufferMask_;
+    AudioBuffer<float> outputBuffer_;
+    int outputBufferLength_;
+    int outputBufferMask_;
+    int inputBufferWritePosition_[STFT_MAX_CHANNELS];
+    int outputBufferReadPosition_[STFT_MAX_CHANNELS];
+    int outputBufferWritePosition_[STFT_MAX_CHANNELS];
+    int samplesSinceLastFFT_[STFT_MAX_CHANNELS];
+
+    JUCE_DECLARE_NON_COPYABLE (STFTEngine)
+};
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "SourcePositionTracker.h"
+
+SourcePositionTracker::SourcePositionTracker()
+{
+    threshold_ = SOURCE_POSITION_DEFAULT_THRESHOLD;
+    azimuth_ = 0.0;
+    elevation_ = 0;
+    valid_ = false;
+}
+
+/*
+  * @brief Set the hysteresis threshold. A threshold of 0 synthesises a new HRTF for any change of position
+  * @param Angle in degrees
+*/
+void SourcePositionTracker::setThreshold(double degrees)
+{
+    threshold_ = jmax(0.0, degrees);
+}
+
+double SourcePositionTracker::getThreshold() const
+{
+    return threshold_;
+}
+
+/*
+  * @brief Forget the tracked position, so the next update always reports a change (e.g. once the HRIR bank has been reloaded)
+*/
+void SourcePositionTracker::reset()
+{
+    valid_ = false;
+}
+
+/*
+  * @brief Compare a new source position with the tracked one. If it has moved by at least the threshold (or nothing is tracked yet), it becomes the tracked position
+  * @param Azimuth in radians, between -π and π as sent by the GUI
+  * @param Elevation in degrees
+  * @return Whether a new HRTF should be synthesised for the position
+*/
+bool SourcePositionTracker::update(double azimuth, int elevation)
+{
+    if (valid_)
+    {
+        if (azimuth == azimuth_ && elevation == elevation_)
+            return false;
+
+        // Measure the movement as the angle between the two directions, so a change of azimuth near the poles counts for as little as it sounds.
+        // Small steps are compared against the tracked position rather than the last one, so a slow drag still adds up to a new HRTF
+        if (angleBetween(azimuth_, deg2rad((double)elevation_), azimuth, deg2rad((double)elevation)) < deg2rad(threshold_))
+            return false;
+    }
+
+    azimuth_ = azimuth;
+    elevation_ = elevation;
+    valid_ = true;
+    return true;
+}
+
+/*
+  * @brief Azimuth in radians of the tracked position, i.e. the one the current HRTF is synthesised for
+*/
+double SourcePositionTracker::getAzimuth() const
+{
+    return azimuth_;
+}
+
+/*
+  * @brief Elevation in degrees of the tracked position
+*/
+int SourcePositionTracker::getElevation() const
+{
+    return elevation_;
+}
+
+/*
+  * @brief Great circle angle between two directions
+  * @param Azimuth and elevation of the first direction, in radians
+  * @param Azimuth and elevation of the second direction, in radians
+  * @return Angle in radians, between 0 and π
+*/
+double SourcePositionTracker::angleBetween(double azimuth1, double elevation1, double azimuth2, double elevation2)
+{
+    // Haversine formula, which unlike the arccosine of the dot product stays accurate for the small angles compared against the threshold
+    const double sinHalfElevation = std::sin(0.5 * (elevation2 - elevation1));
+    const double sinHalfAzimuth = std::sin(0.5 * (azimuth2 - azimuth1));
+    const double h = sinHalfElevation * sinHalfElevation + std::cos(elevation1) * std::cos(elevation2) * sinHalfAzimuth * sinHalfAzimuth;
+    return 2.0 * std::asin(std::sqrt(jlimit(0.0, 1.0, h)));
+}
+
+SourcePositionTracker::~SourcePositionTracker()
+{
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Util.h"
+
+// Default angle, in degrees, the source must move from the position the current HRTF was synthesised for before a new one is synthesised. Well below the
+// resolution of the 30° HRIR grid the HRTF is blended from
+#define SOURCE_POSITION_DEFAULT_THRESHOLD 1.0
+
+// Tracks the source position the current HRTF was synthesised for, and decides whether a new position is far enough from it to need a new one
+class SourcePositionTracker
+{
+public:
+    SourcePositionTracker();
+    ~SourcePositionTracker();
+
+    void setThreshold(double degrees);
+    double getThreshold() const;
+    void reset();
+    bool update(double azimuth, int elevation);
+
+    double getAzimuth() const;
+    int getElevation() const;
+
+private:
+    static double angleBetween(double azimuth1, double elevation1, double azimuth2, double elevation2);
+
+    double threshold_;
+    double azimuth_;
+    int elevation_;
+    bool valid_;
+
+    JUCE_DECLARE_NON_COPYABLE (SourcePositionTracker)
+};
@@ -0,0 +1,341 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SpectralTypes.h"
+#include <cmath>
+
+// SIMD building blocks shared by the spectral kernels. Only included by the .cpp files that implement kernels, so the intrinsics stay out of every other translation unit
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <immintrin.h>
+#endif
+
+// The NEON lanes have not been built and checked against the scalar kernels on an ARM target yet, so ARM builds use the scalar lanes unless they are asked for
+#ifndef BPV_NEON_LANES
+ #define BPV_NEON_LANES 0
+#endif
+
+//==============================================================================
+// Lane types. Each wraps one instruction set and sample type behind the same handful of operations, so each kernel is written once. Complex bins are
+// loaded de-interleaved into a vector of real parts and a vector of imaginary parts, in bin order, and re-interleaved on store
+
+template <typename Sample>
+struct ScalarLanes
+{
+    typedef Sample Scalar;
+    typedef Sample Vec;
+    enum { width = 1 };
+
+    static inline Vec set1(double v)                           { return (Sample)v; }
+    static inline Vec load(const Scalar* p)                    { return *p; }
+    static inline void store(Scalar* p, Vec a)                 { *p = a; }
+    static inline Vec add(Vec a, Vec b)                        { return a + b; }
+    static inline Vec sub(Vec a, Vec b)                        { return a - b; }
+    static inline Vec mul(Vec a, Vec b)                        { return a * b; }
+    static inline Vec sqrt(Vec a)                              { return std::sqrt(a); }
+    static inline Vec round(Vec a)                             { return std::nearbyint(a); }
+    static inline void loadComplex(const Scalar* p, Vec& re, Vec& im)   { re = p[0]; im = p[1]; }
+    static inline void storeComplex(Scalar* p, Vec re, Vec im)         { p[0] = re; p[1] = im; }
+};
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+struct SSE2DoubleLanes
+{
+    typedef double Scalar;
+    typedef __m128d Vec;
+    enum { width = 2 };
+
+    static inline Vec set1(double v)                           { return _mm_set1_pd(v); }
+    static inline Vec load(const Scalar* p)                    { return _mm_loadu_pd(p); }
+    static inline void store(Scalar* p, Vec a)                 { _mm_storeu_pd(p, a); }
+    static inline Vec add(Vec a, Vec b)                        { return _mm_add_pd(a, b); }
+    static inline Vec sub(Vec a, Vec b)                        { return _mm_sub_pd(a, b); }
+    static inline Vec mul(Vec a, Vec b)                        { return _mm_mul_pd(a, b); }
+    static inline Vec sqrt(Vec a)                              { return _mm_sqrt_pd(a); }
+    // SSE2 has no rounding instruction, but converting to int32 rounds to nearest
+    static inline Vec round(Vec a)                             { return _mm_cvtepi32_pd(_mm_cvtpd_epi32(a)); }
+
+    static inline void loadComplex(const Scalar* p, Vec& re, Vec& im)
+    {
+        const Vec a = _mm_loadu_pd(p);          // r0 i0
+        const Vec b = _mm_loadu_pd(p + 2);      // r1 i1
+        re = _mm_unpacklo_pd(a, b);
+        im = _mm_unpackhi_pd(a, b);
+    }
+
+    static inline void storeComplex(Scalar* p, Vec re, Vec im)
+    {
+        _mm_storeu_pd(p, _mm_unpacklo_pd(re, im));
+        _mm_storeu_pd(p + 2, _mm_unpackhi_pd(re, im));
+    }
+};
+
+struct SSE2FloatLanes
+{
+    typedef float Scalar;
+    typedef __m128 Vec;
+    enum { width = 4 };
+
+    static inline Vec set1(double v)                           { return _mm_set1_ps((float)v); }
+    static inline Vec load(const Scalar* p)                    { return _mm_loadu_ps(p); }
+    static inline void store(Scalar* p, Vec a)                 { _mm_storeu_ps(p, a); }
+    static inline Vec add(Vec a, Vec b)                        { return _mm_add_ps(a, b); }
+    static inline Vec sub(Vec a, Vec b)                        { return _mm_sub_ps(a, b); }
+    static inline Vec mul(Vec a, Vec b)                        { return _mm_mul_ps(a, b); }
+    static inline Vec sqrt(Vec a)                              { return _mm_sqrt_ps(a); }
+    static inline Vec round(Vec a)                             { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+
+    static inline void loadComplex(const Scalar* p, Vec& re, Vec& im)
+    {
+        const Vec a = _mm_loadu_ps(p);          // r0 i0 r1 i1
+        const Vec b = _mm_loadu_ps(p + 4);      // r2 i2 r3 i3
+        re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+
+    static inline void storeComplex(Scalar* p, Vec re, Vec im)
+    {
+        _mm_storeu_ps(p, _mm_unpacklo_ps(re, im));
+        _mm_storeu_ps(p + 4, _mm_unpackhi_ps(re, im));
+    }
+};
+#endif
+
+#if defined(__AVX2__)
+struct AVX2DoubleLanes
+{
+    typedef double Scalar;
+    typedef __m256d Vec;
+    enum { width = 4 };
+
+    static inline Vec set1(double v)                           { return _mm256_set1_pd(v); }
+    static inline Vec load(const Scalar* p)                    { return _mm256_loadu_pd(p); }
+    static inline void store(Scalar* p, Vec a)                 { _mm256_storeu_pd(p, a); }
+    static inline Vec add(Vec a, Vec b)                        { return _mm256_add_pd(a, b); }
+    static inline Vec sub(Vec a, Vec b)                        { return _mm256_sub_pd(a, b); }
+    static inline Vec mul(Vec a, Vec b)                        { return _mm256_mul_pd(a, b); }
+    static inline Vec sqrt(Vec a)                              { return _mm256_sqrt_pd(a); }
+    static inline Vec round(Vec a)                             { return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+    static inline void loadComplex(const Scalar* p, Vec& re, Vec& im)
+    {
+        const Vec a = _mm256_loadu_pd(p);       // r0 i0 r1 i1
+        const Vec b = _mm256_loadu_pd(p + 4);   // r2 i2 r3 i3
+        // unpack works within 128-bit halves, giving r0 r2 r1 r3; swapping the middle pair restores bin order
+        re = _mm256_permute4x64_pd(_mm256_unpacklo_pd(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        im = _mm256_permute4x64_pd(_mm256_unpackhi_pd(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+    }
+
+    static inline void storeComplex(Scalar* p, Vec re, Vec im)
+    {
+        re = _mm256_permute4x64_pd(re, _MM_SHUFFLE(3, 1, 2, 0));
+        im = _mm256_permute4x64_pd(im, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_pd(p, _mm256_unpacklo_pd(re, im));
+        _mm256_storeu_pd(p + 4, _mm256_unpackhi_pd(re, im));
+    }
+};
+
+struct AVX2FloatLanes
+{
+    typedef float Scalar;
+    typedef __m256 Vec;
+    enum { width = 8 };
+
+    static inline Vec set1(double v)                           { return _mm256_set1_ps((float)v); }
+    static inline Vec load(const Scalar* p)                    { return _mm256_loadu_ps(p); }
+    static inline void store(Scalar* p, Vec a)                 { _mm256_storeu_ps(p, a); }
+    static inline Vec add(Vec a, Vec b)                        { return _mm256_add_ps(a, b); }
+    static inline Vec sub(Vec a, Vec b)                        { return _mm256_sub_ps(a, b); }
+    static inline Vec mul(Vec a, Vec b)                        { return _mm256_mul_ps(a, b); }
+    static inline Vec sqrt(Vec a)                              { return _mm256_sqrt_ps(a); }
+    static inline Vec round(Vec a)                             { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+    // Shuffles work within 128-bit halves, leaving the pairs of bins in the order 0 2 1 3; swapping the middle two 64-bit pairs restores bin order
+    static inline Vec swapMiddlePairs(Vec a)
+    {
+        return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(a), _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+
+    static inline void loadComplex(const Scalar* p, Vec& re, Vec& im)
+    {
+        const Vec a = _mm256_loadu_ps(p);       // r0 i0 r1 i1 r2 i2 r3 i3
+        const Vec b = _mm256_loadu_ps(p + 8);   // r4 i4 r5 i5 r6 i6 r7 i7
+        re = swapMiddlePairs(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        im = swapMiddlePairs(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    static inline void storeComplex(Scalar* p, Vec re, Vec im)
+    {
+        re = swapMiddlePairs(re);
+        im = swapMiddlePairs(im);
+        _mm256_storeu_ps(p, _mm256_unpacklo_ps(re, im));
+        _mm256_storeu_ps(p + 8, _mm256_unpackhi_ps(re, im));
+    }
+};
+#endif
+
+#if BPV_NEON_LANES && defined(__ARM_NEON) && defined(__aarch64__)
+ #include <arm_neon.h>
+
+struct NEONDoubleLanes
+{
+    typedef double Scalar;
+    typedef float64x2_t Vec;
+    enum { width = 2 };
+
+    static inline Vec set1(double v)                           { return vdupq_n_f64(v); }
+    static inline Vec load(const Scalar* p)                    { return vld1q_f64(p); }
+    static inline void store(Scalar* p, Vec a)                 { vst1q_f64(p, a); }
+    static inline Vec add(Vec a, Vec b)                        { return vaddq_f64(a, b); }
+    static inline Vec sub(Vec a, Vec b)                        { return vsubq_f64(a, b); }
+    static inline Vec mul(Vec a, Vec b)                        { return vmulq_f64(a, b); }
+    static inline Vec sqrt(Vec a)                              { return vsqrtq_f64(a); }
+    static inline Vec round(Vec a)                             { return vrndnq_f64(a); }
+
+    // vld2/vst2 de-interleave and re-interleave the bins in one instruction
+    static inline void loadComplex(const Scalar* p, Vec& re, Vec& im)
+    {
+        const float64x2x2_t bins = vld2q_f64(p);
+        re = bins.val[0];
+        im = bins.val[1];
+    }
+
+    static inline void storeComplex(Scalar* p, Vec re, Vec im)
+    {
+        float64x2x2_t bins;
+        bins.val[0] = re;
+        bins.val[1] = im;
+        vst2q_f64(p, bins);
+    }
+};
+
+struct NEONFloatLanes
+{
+    typedef float Scalar;
+    typedef float32x4_t Vec;
+    enum { width = 4 };
+
+    static inline Vec set1(double v)                           { return vdupq_n_f32((float)v); }
+    static inline Vec load(const Scalar* p)                    { return vld1q_f32(p); }
+    static inline void store(Scalar* p, Vec a)                 { vst1q_f32(p, a); }
+    static inline Vec add(Vec a, Vec b)                        { return vaddq_f32(a, b); }
+    static inline Vec sub(Vec a, Vec b)                        { return vsubq_f32(a, b); }
+    static inline Vec mul(Vec a, Vec b)                        { return vmulq_f32(a, b); }
+    static inline Vec sqrt(Vec a)                              { return vsqrtq_f32(a); }
+    static inline Vec round(Vec a)                             { return vrndnq_f32(a); }
+
+    static inline void loadComplex(const Scalar* p, Vec& re, Vec& im)
+    {
+        const float32x4x2_t bins = vld2q_f32(p);
+        re = bins.val[0];
+        im = bins.val[1];
+    }
+
+    static inline void storeComplex(Scalar* p, Vec re, Vec im)
+    {
+        float32x4x2_t bins;
+        bins.val[0] = re;
+        bins.val[1] = im;
+        vst2q_f32(p, bins);
+    }
+};
+#endif
+
+// The widest lanes available for the spectral path's sample type
+#if defined(__AVX2__) && BPV_DOUBLE_PRECISION
+typedef AVX2DoubleLanes NativeLanes;
+#elif defined(__AVX2__)
+typedef AVX2FloatLanes NativeLanes;
+#elif (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && BPV_DOUBLE_PRECISION
+typedef SSE2DoubleLanes NativeLanes;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+typedef SSE2FloatLanes NativeLanes;
+#elif BPV_NEON_LANES && defined(__ARM_NEON) && defined(__aarch64__) && BPV_DOUBLE_PRECISION
+typedef NEONDoubleLanes NativeLanes;
+#elif BPV_NEON_LANES && defined(__ARM_NEON) && defined(__aarch64__)
+typedef NEONFloatLanes NativeLanes;
+#else
+typedef ScalarLanes<SpectralSample> NativeLanes;
+#endif
+typedef ScalarLanes<SpectralSample> TailLanes;
+
+// The widest lanes available for float audio buffers, whatever the spectral path's sample type
+#if defined(__AVX2__)
+typedef AVX2FloatLanes NativeFloatLanes;
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+typedef SSE2FloatLanes NativeFloatLanes;
+#elif BPV_NEON_LANES && defined(__ARM_NEON) && defined(__aarch64__)
+typedef NEONFloatLanes NativeFloatLanes;
+#else
+typedef ScalarLanes<float> NativeFloatLanes;
+#endif
+typedef ScalarLanes<float> TailFloatLanes;
+
+//==============================================================================
+/*
+  * @brief Polynomial sine and cosine of a vector of phases, accurate for |phase| up to a few thousand radians
+  * @param Phases in radians
+  * @param Output sines
+  * @param Output cosines
+  * @param True for the higher order polynomials
+*/
+template <typename L>
+static inline void sinCos(typename L::Vec phase, typename L::Vec& sine, typename L::Vec& cosine, bool highAccuracy)
+{
+    typedef typename L::Vec Vec;
+
+    // Reduce to r in [-π/4, π/4] around the nearest multiple q of π/2. π/2 is split in three, the first two short enough that their products with q are
+    // exact even in single precision
+    const Vec q = L::round(L::mul(phase, L::set1(2.0 / M_PI)));
+    Vec r = L::sub(phase, L::mul(q, L::set1(1.5703125)));
+    r = L::sub(r, L::mul(q, L::set1(4.837512969970703125e-4)));
+    r = L::sub(r, L::mul(q, L::set1(7.5497899548921012e-08)));
+    const Vec r2 = L::mul(r, r);
+
+    // Taylor series of sin(r) and cos(r), in Horner form
+    Vec s, c;
+    if (highAccuracy)
+    {
+        s = L::set1(1.0 / 6227020800.0);
+        s = L::add(L::mul(s, r2), L::set1(-1.0 / 39916800.0));
+        s = L::add(L::mul(s, r2), L::set1(1.0 / 362880.0));
+        s = L::add(L::mul(s, r2), L::set1(-1.0 / 5040.0));
+        c = L::set1(-1.0 / 87178291200.0);
+        c = L::add(L::mul(c, r2), L::set1(1.0 / 479001600.0));
+        c = L::add(L::mul(c, r2), L::set1(-1.0 / 3628800.0));
+        c = L::add(L::mul(c, r2), L::set1(1.0 / 40320.0));
+    }
+    else
+    {
+        s = L::set1(-1.0 / 5040.0);
+        c = L::set1(1.0 / 40320.0);
+    }
+    s = L::add(L::mul(s, r2), L::set1(1.0 / 120.0));
+    s = L::add(L::mul(s, r2), L::set1(-1.0 / 6.0));
+    s = L::add(L::mul(L::mul(s, r2), r), r);
+    c = L::add(L::mul(c, r2), L::set1(-1.0 / 720.0));
+    c = L::add(L::mul(c, r2), L::set1(1.0 / 24.0));
+    c = L::add(L::mul(c, r2), L::set1(-0.5));
+    c = L::add(L::mul(c, r2), L::set1(1.0));
+
+    // Quadrant q mod 4 as two bits, found by rounding rather than integer ops so every lane type can do it. Bit 0 swaps sine and cosine, and
+    // the signs follow sin = (s, c, -s, -c) and cos = (c, -s, -c, s) for quadrants 0 to 3
+    const Vec quadrant = L::sub(q, L::mul(L::set1(4.0), L::round(L::sub(L::mul(q, L::set1(0.25)), L::set1(0.375)))));
+    const Vec bit1 = L::round(L::sub(L::mul(quadrant, L::set1(0.5)), L::set1(0.25)));
+    const Vec bit0 = L::sub(quadrant, L::add(bit1, bit1));
+    const Vec bitsDiffer = L::sub(L::add(bit0, bit1), L::mul(L::set1(2.0), L::mul(bit0, bit1)));
+
+    const Vec swappedSine = L::add(s, L::mul(bit0, L::sub(c, s)));
+    const Vec swappedCosine = L::add(c, L::mul(bit0, L::sub(s, c)));
+    sine = L::mul(swappedSine, L::sub(L::set1(1.0), L::add(bit1, bit1)));
+    cosine = L::mul(swappedCosine, L::sub(L::set1(1.0), L::add(bitsDiffer, bitsDiffer)));
+}
@@ -0,0 +1,31 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <api/fftw3.h>
+
+// Precision of the whole spectral path (the phase vocoder's STFT, the HRIR spectra and their blend). 0 builds it on single precision fftwf_* plans and
+// float buffers, which halves the memory traffic and doubles the SIMD width. 1 builds it on double precision fftw_* for comparison. Both libraries must be linked
+#ifndef BPV_DOUBLE_PRECISION
+ #define BPV_DOUBLE_PRECISION 0
+#endif
+
+// FFTWP(plan_many_dft_r2c) expands to fftwf_plan_many_dft_r2c or fftw_plan_many_dft_r2c
+#if BPV_DOUBLE_PRECISION
+ #define FFTWP(name) fftw_ ## name
+ typedef double SpectralSample;
+#else
+ #define FFTWP(name) fftwf_ ## name
+ typedef float SpectralSample;
+#endif
+
+typedef FFTWP(complex) SpectralComplex;
+typedef FFTWP(plan) SpectralPlan;
@@ -0,0 +1,178 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include "VocoderKernels.h"
+#include "SpectralLanes.h"
+
+template <typename L>
+static int scaleLanes(SpectralComplex* spectrum, int numBins, double gain)
+{
+    const typename L::Vec g = L::set1(gain);
+    int i = 0;
+
+    for (; i + L::width <= numBins; i += L::width)
+    {
+        typename L::Vec re, im;
+        L::loadComplex(&spectrum[i][0], re, im);
+        L::storeComplex(&spectrum[i][0], L::mul(re, g), L::mul(im, g));
+    }
+    return i;
+}
+
+template <typename L>
+static int magnitudeLanes(SpectralComplex* spectrum, int numBins, double gain)
+{
+    const typename L::Vec g = L::set1(gain);
+    int i = 0;
+
+    for (; i + L::width <= numBins; i += L::width)
+    {
+        typename L::Vec re, im;
+        L::loadComplex(&spectrum[i][0], re, im);
+        const typename L::Vec amplitude = L::mul(L::sqrt(L::add(L::mul(re, re), L::mul(im, im))), g);
+        L::storeComplex(&spectrum[i][0], amplitude, L::set1(0.0));
+    }
+    return i;
+}
+
+template <typename L>
+static int randomPhaseLanes(SpectralComplex* spectrum, int numBins, double gain, const SpectralSample* phases, bool highAccuracy)
+{
+    const typename L::Vec g = L::set1(gain);
+    int i = 0;
+
+    for (; i + L::width <= numBins; i += L::width)
+    {
+        typename L::Vec re, im, sine, cosine;
+        L::loadComplex(&spectrum[i][0], re, im);
+        const typename L::Vec amplitude = L::mul(L::sqrt(L::add(L::mul(re, re), L::mul(im, im))), g);
+        sinCos<L>(L::load(phases + i), sine, cosine, highAccuracy);
+        L::storeComplex(&spectrum[i][0], L::mul(amplitude, cosine), L::mul(amplitude, sine));
+    }
+    return i;
+}
+
+template <typename L>
+static int phasorLanes(SpectralComplex* spectrum, int numBins, double gain, const SpectralComplex* phasors)
+{
+    const typename L::Vec g = L::set1(gain);
+    int i = 0;
+
+    for (; i + L::width <= numBins; i += L::width)
+    {
+        typename L::Vec re, im, cosine, sine;
+        L::loadComplex(&spectrum[i][0], re, im);
+        L::loadComplex(&phasors[i][0], cosine, sine);
+        const typename L::Vec amplitude = L::mul(L::sqrt(L::add(L::mul(re, re), L::mul(im, im))), g);
+        L::storeComplex(&spectrum[i][0], L::mul(amplitude, cosine), L::mul(amplitude, sine));
+    }
+    return i;
+}
+
+//==============================================================================
+/*
+  * @brief Pass-through vocoder: keep each bin's phase and scale its magnitude
+  * @param First K/2 + 1 bins of the frame's spectrum, modified in place
+  * @param Number of bins
+  * @param Magnitude gain
+  * @param Accuracy level. Above exact the magnitude/phase round trip is skipped, since r cos(atan2(y, x)) = x and r sin(atan2(y, x)) = y
+*/
+void VocoderKernels::passthrough(SpectralComplex* spectrum, int numBins, double gain, int accuracy)
+{
+    int i = 0;
+
+    if (accuracy != exactAccuracy)
+    {
+        i = scaleLanes<NativeLanes>(spectrum, numBins, gain);
+        scaleLanes<TailLanes>(spectrum + i, numBins - i, gain);
+        return;
+    }
+
+    for (; i < numBins; i++)
+    {
+        const SpectralSample amplitude = std::sqrt(spectrum[i][0] * spectrum[i][0] + spectrum[i][1] * spectrum[i][1]) * (SpectralSample)gain;
+        const SpectralSample phase = std::atan2(spectrum[i][1], spectrum[i][0]);
+        spectrum[i][0] = amplitude * std::cos(phase);
+        spectrum[i][1] = amplitude * std::sin(phase);
+    }
+}
+
+/*
+  * @brief Robotisation: keep each bin's magnitude and set its phase to 0
+  * @param First K/2 + 1 bins of the frame's spectrum, modified in place
+  * @param Number of bins
+  * @param Magnitude gain
+  * @param Accuracy level. Only the exact level stays scalar, as the SIMD square root is exact too
+*/
+void VocoderKernels::robotise(SpectralComplex* spectrum, int numBins, double gain, int accuracy)
+{
+    int i = 0;
+
+    if (accuracy != exactAccuracy)
+        i = magnitudeLanes<NativeLanes>(spectrum, numBins, gain);
+
+    magnitudeLanes<TailLanes>(spectrum + i, numBins - i, gain);
+}
+
+/*
+  * @brief Whisperisation: keep each bin's magnitude and replace its phase
+  * @param First K/2 + 1 bins of the frame's spectrum, modified in place
+  * @param Number of bins
+  * @param Magnitude gain
+  * @param New phase for each bin, in radians
+  * @param Accuracy level
+*/
+void VocoderKernels::whisperise(SpectralComplex* spectrum, int numBins, double gain, const SpectralSample* phases, int accuracy)
+{
+    int i = 0;
+
+    if (accuracy != exactAccuracy)
+    {
+        i = randomPhaseLanes<NativeLanes>(spectrum, numBins, gain, phases, accuracy == highAccuracy);
+        randomPhaseLanes<TailLanes>(spectrum + i, numBins - i, gain, phases + i, accuracy == highAccuracy);
+        return;
+    }
+
+    for (; i < numBins; i++)
+    {
+        const SpectralSample amplitude = std::sqrt(spectrum[i][0] * spectrum[i][0] + spectrum[i][1] * spectrum[i][1]) * (SpectralSample)gain;
+        spectrum[i][0] = amplitude * std::cos(phases[i]);
+        spectrum[i][1] = amplitude * std::sin(phases[i]);
+    }
+}
+
+/*
+  * @brief Whisperisation with the new phases given as unit phasors, so no cos or sin is evaluated at all
+  * @param First K/2 + 1 bins of the frame's spectrum, modified in place
+  * @param Number of bins
+  * @param Magnitude gain
+  * @param Unit phasor (cos, sin) for each bin
+*/
+void VocoderKernels::whisperise(SpectralComplex* spectrum, int numBins, double gain, const SpectralComplex* phasors)
+{
+    const int i = phasorLanes<NativeLanes>(spectrum, numBins, gain, phasors);
+    phasorLanes<TailLanes>(spectrum + i, numBins - i, gain, phasors + i);
+}
+
+/*
+  * @brief Name of the instruction set the SIMD accuracy levels were compiled for
+*/
+const char* VocoderKernels::getInstructionSetName()
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return "SSE2";
+#elif BPV_NEON_LANES && defined(__ARM_NEON) && defined(__aarch64__)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
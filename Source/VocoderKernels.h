@@ -0,0 +1,32 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SpectralTypes.h"
+
+class VocoderKernels
+{
+public:
+    // How the magnitude/phase round trip is evaluated
+    enum Accuracy
+    {
+        exactAccuracy = 0,      // Scalar sqrt, atan2, cos and sin from libm, bin by bin
+        highAccuracy,           // SIMD lanes, 13th/14th order polynomials for cos and sin (error below 1e-12 in double precision builds, float rounding otherwise)
+        fastAccuracy            // SIMD lanes, 7th/8th order polynomials for cos and sin (error below 1e-6), and whisperisation from a phasor table
+    };
+
+    static void passthrough(SpectralComplex* spectrum, int numBins, double gain, int accuracy);
+    static void robotise(SpectralComplex* spectrum, int numBins, double gain, int accuracy);
+    static void whisperise(SpectralComplex* spectrum, int numBins, double gain, const SpectralSample* phases, int accuracy);
+    static void whisperise(SpectralComplex* spectrum, int numBins, double gain, const SpectralComplex* phasors);
+
+    static const char* getInstructionSetName();
+};
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+// Sample rate and largest block the processor is prepared for, and the number of blocks run through each mode. The blocks are of random length up to the largest
+#define AUDIO_THREAD_GUARD_TEST_SAMPLE_RATE 44100.0
+#define AUDIO_THREAD_GUARD_TEST_NUM_BLOCKS 200
+#define AUDIO_THREAD_GUARD_TEST_MOVE_INTERVAL 3
+
+// Runs processBlock under the guard (this target is built with BPV_AUDIO_THREAD_GUARD=1) through every vocoder effect and HRTF stage, moving the source part way
+// through so new filters are loaded mid-stream, and checks the audio thread never allocates or takes a lock
+class AudioThreadGuardTest  : public UnitTest
+{
+public:
+    AudioThreadGuardTest() : UnitTest ("AudioThreadGuard", "DAFX") {}
+
+    void runTest() override
+    {
+        beginTest ("Guard is compiled in");
+
+        // Otherwise every count below would be 0 whatever processBlock did
+        AudioThreadGuard::resetViolations();
+        {
+            AudioThreadGuard::ScopedRealtime realtime;
+            AudioThreadGuard::check("test");
+        }
+        expectEquals (AudioThreadGuard::getViolationCount(), 1, "build with BPV_AUDIO_THREAD_GUARD=1");
+
+        beginTest ("processBlock neither allocates nor locks");
+
+        // Fixed seed, so a failure is repeatable
+        Random random (1);
+
+        // Each convolver, with the partitioned one also at a block size that is not whole partitions (its FIFO path), and the HRTF fused into the vocoder
+        struct HRTFStage { bool fused; int convolverMode; int blockSize; const char* name; };
+        const HRTFStage stages[] = {
+            { false, HRTFConvolverSelector::directConvolver,      512, "direct" },
+            { false, HRTFConvolverSelector::partitionedConvolver, 512, "partitioned" },
+            { false, HRTFConvolverSelector::partitionedConvolver, 480, "partitioned, unaligned" },
+            { false, HRTFConvolverSelector::hybridConvolver,      512, "hybrid" },
+            { true,  HRTFConvolverSelector::automaticConvolver,   512, "fused" }
+        };
+
+        for (const HRTFStage& stage : stages)
+        {
+            for (int effect = 0; effect < 3; ++effect)
+            {
+                for (int accuracy : { (int)VocoderKernels::highAccuracy, (int)VocoderKernels::fastAccuracy })
+                {
+                    const String name = String(stage.name) + ", effect " + String(effect) + ", accuracy " + String(accuracy);
+                    const int numViolations = runBlocks(stage.fused, stage.convolverMode, stage.blockSize, effect, accuracy, random);
+                    const char* lastViolation = AudioThreadGuard::getLastViolation();
+                    expectEquals (numViolations, 0, name + (lastViolation != nullptr ? String(": ") + lastViolation : String()));
+                }
+            }
+        }
+    }
+
+private:
+    /*
+      * @brief Prepare a processor and run blocks through it, moving the source every few blocks from this (the message) thread
+      * @param Whether the HRTF is fused into the vocoder
+      * @param HRTFConvolverSelector mode, when it is not
+      * @param Block size the processor is prepared for
+      * @param Vocoder effect: 0 pass-through, 1 robotisation, 2 whisperisation
+      * @param VocoderKernels accuracy
+      * @param Source of the input and block lengths
+      * @return Number of violations reported while the blocks were processed
+    */
+    int runBlocks(bool fused, int convolverMode, int blockSize, int effect, int accuracy, Random& random)
+    {
+        DafxBinauralPhaseVocoderAudioProcessor processor;
+        processor.bypass = false;
+        processor.passthrough = effect == 0;
+        processor.robotisation = effect == 1;
+        processor.whisperisation = effect == 2;
+        processor.vocoderAccuracy = accuracy;
+        processor.audioGain = 0.5f;
+        processor.distance = 1.0f;
+        processor.fusedHRTF = fused;
+        processor.hrtfConvolverMode = convolverMode;
+        // The dense grid only changes where the message thread gets each filter from, so leave it out rather than wait for it
+        processor.denseHRTFGrid = false;
+        processor.setSTFTConfiguration(1024, 4, STFTEngine::sqrtHannWindow);
+        processor.prepareToPlay(AUDIO_THREAD_GUARD_TEST_SAMPLE_RATE, blockSize);
+
+        AudioSampleBuffer buffer (2, blockSize);
+        MidiBuffer midiMessages;
+        AudioThreadGuard::resetViolations();
+
+        for (int b = 0; b < AUDIO_THREAD_GUARD_TEST_NUM_BLOCKS; ++b)
+        {
+            // Far enough to clear the hysteresis threshold, often enough that some filters arrive while the previous crossfade is still running
+            if (b % AUDIO_THREAD_GUARD_TEST_MOVE_INTERVAL == AUDIO_THREAD_GUARD_TEST_MOVE_INTERVAL - 1)
+            {
+                processor.azimuth = std::fmod(processor.azimuth + 40.0, 360.0);
+                processor.elevation = processor.elevation == 0 ? 30 : 0;
+                processor.updateHRTF();
+            }
+
+            const int numSamples = 1 + random.nextInt(blockSize);
+            buffer.setSize(2, numSamples, false, false, true);
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    buffer.setSample(channel, i, random.nextFloat() * 2.0f - 1.0f);
+                }
+            }
+
+            processor.processBlock(buffer, midiMessages);
+        }
+
+        const int numViolations = AudioThreadGuard::getViolationCount();
+        processor.releaseResources();
+        return numViolations;
+    }
+};
+
+static AudioThreadGuardTest audioThreadGuardTest;
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/FractionalDelayLine.h"
+
+// Longest delay asked of the line, and the block size it is prepared for, which is above FRACTIONAL_DELAY_MAX_BLOCK so longer blocks are split
+#define FRACTIONAL_DELAY_TEST_MAX_DELAY 40
+#define FRACTIONAL_DELAY_TEST_BLOCK_SIZE 512
+#define FRACTIONAL_DELAY_TEST_NUM_BLOCKS 200
+
+// Checks the delay line, with its wrapped buffer, split blocks and vectorised held delays, against a Lagrange interpolator reading straight from the whole input
+class FractionalDelayLineTest  : public UnitTest
+{
+public:
+    FractionalDelayLineTest() : UnitTest ("FractionalDelayLine", "DAFX") {}
+
+    void runTest() override
+    {
+        beginTest ("Held and gliding delays match the reference over random blocks");
+
+        // Fixed seed, so a failure is repeatable
+        Random random (1);
+
+        FractionalDelayLine delayLine;
+        delayLine.prepare(FRACTIONAL_DELAY_MAX_CHANNELS, FRACTIONAL_DELAY_TEST_MAX_DELAY, FRACTIONAL_DELAY_TEST_BLOCK_SIZE);
+
+        std::vector<float> input[FRACTIONAL_DELAY_MAX_CHANNELS];
+        double delay[FRACTIONAL_DELAY_MAX_CHANNELS];
+        for (int channel = 0; channel < FRACTIONAL_DELAY_MAX_CHANNELS; ++channel)
+        {
+            delay[channel] = delayLine.getDelay(channel);
+        }
+
+        AudioSampleBuffer block (FRACTIONAL_DELAY_MAX_CHANNELS, FRACTIONAL_DELAY_TEST_BLOCK_SIZE);
+        double maxDifference = 0.0;
+
+        for (int b = 0; b < FRACTIONAL_DELAY_TEST_NUM_BLOCKS; ++b)
+        {
+            // Block sizes from a single sample to past FRACTIONAL_DELAY_MAX_BLOCK
+            const int numSamples = 1 + random.nextInt(FRACTIONAL_DELAY_TEST_BLOCK_SIZE);
+            const float gain = 0.5f + random.nextFloat();
+
+            for (int channel = 0; channel < FRACTIONAL_DELAY_MAX_CHANNELS; ++channel)
+            {
+                // About a third of the blocks hold the delay still, which takes the vectorised path
+                const double startDelay = delay[channel];
+                const double targetDelay = random.nextInt(3) == 0 ? startDelay
+                                                                  : FRACTIONAL_DELAY_MIN_SAMPLES + random.nextDouble() * (FRACTIONAL_DELAY_TEST_MAX_DELAY - FRACTIONAL_DELAY_MIN_SAMPLES);
+                delayLine.setDelay(channel, targetDelay);
+
+                float* data = block.getWritePointer(channel);
+                const int blockStart = (int)input[channel].size();
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    data[i] = 2.0f * random.nextFloat() - 1.0f;
+                    input[channel].push_back(data[i]);
+                }
+
+                delayLine.process(channel, data, numSamples, gain);
+
+                const double delayIncrement = (targetDelay - startDelay) / numSamples;
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const double expected = gain * readReference(input[channel], blockStart + i, startDelay + delayIncrement * (i + 1));
+                    maxDifference = jmax(maxDifference, std::abs(data[i] - expected));
+                }
+
+                delay[channel] = targetDelay;
+                expectWithinAbsoluteError (delayLine.getDelay(channel), targetDelay, 1.0e-12);
+            }
+        }
+
+        expectLessThan (maxDifference, 1.0e-5);
+    }
+
+private:
+    /*
+      * @brief Third-order Lagrange interpolation of the input at a fractional delay, from the four samples around it, taking the input as silent before it starts
+      * @param Every input sample so far
+      * @param Index of the output sample
+      * @param Delay in samples
+    */
+    static double readReference(const std::vector<float>& input, int index, double delay)
+    {
+        const int wholeDelay = (int)std::floor(delay);
+        const double f = delay - wholeDelay;
+
+        // Nodes at delays D - 1, D, D + 1 and D + 2 around D + f
+        const double nodes[] = { -1.0, 0.0, 1.0, 2.0 };
+        double sum = 0.0;
+
+        for (int k = 0; k < 4; ++k)
+        {
+            double weight = 1.0;
+            for (int j = 0; j < 4; ++j)
+            {
+                if (j != k)
+                    weight *= (f - nodes[j]) / (nodes[k] - nodes[j]);
+            }
+
+            const int position = index - wholeDelay - (int)nodes[k];
+            if (position >= 0 && position <= index)
+                sum += weight * input[(size_t)position];
+        }
+        return sum;
+    }
+};
+
+static FractionalDelayLineTest fractionalDelayLineTest;
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/HRTFBlendKernels.h"
+
+// Number of bins of the spectra the blend is applied to by IRCrossfade
+#define HRTF_BLEND_TEST_MAX_BINS (HRIR_SPECTRUM_TRANSFORM_SIZE/2 + 1)
+
+// Checks the SIMD blend against its scalar reference, for the lanes the build dispatches to
+class HRTFBlendKernelsTest  : public UnitTest
+{
+public:
+    HRTFBlendKernelsTest() : UnitTest ("HRTFBlendKernels", "DAFX") {}
+
+    void runTest() override
+    {
+        beginTest ("SIMD blend matches the scalar reference");
+
+        // Bin counts that end on and off a whole vector, and no delay, a quarter-transform delay and a delay that is no fraction of the transform
+        const int numBins[] = { 1, 7, 64, 257, HRTF_BLEND_TEST_MAX_BINS };
+        const double delayPhaseIncrements[] = { 0.0, -0.5 * M_PI, 0.0123 };
+
+        for (int bins : numBins)
+        {
+            for (int numSpectra = 1; numSpectra <= HRTF_BLEND_MAX_SPECTRA; ++numSpectra)
+            {
+                for (double delayPhaseIncrement : delayPhaseIncrements)
+                {
+                    expectLessThan (measureError(bins, numSpectra, delayPhaseIncrement), 1.0e-4,
+                                    String(bins) + " bins, " + String(numSpectra) + " spectra, phase increment " + String(delayPhaseIncrement));
+                }
+            }
+        }
+    }
+
+private:
+    /*
+      * @brief Blend random spectra with both blend and blendReference, and compare
+      * @param Number of bins, at most HRTF_BLEND_TEST_MAX_BINS
+      * @param Number of spectra, at most HRTF_BLEND_MAX_SPECTRA
+      * @param Phase added per bin, in radians
+      * @return Largest difference between the two outputs, relative to the largest output bin
+    */
+    double measureError(int numBins, int numSpectra, double delayPhaseIncrement)
+    {
+        // Fixed seed, so a failure is repeatable
+        Random random (1);
+
+        for (int n = 0; n < numSpectra; ++n)
+        {
+            for (int i = 0; i < numBins; i++)
+            {
+                real_[n][i] = (SpectralSample)(2.0 * random.nextDouble() - 1.0);
+                imag_[n][i] = (SpectralSample)(2.0 * random.nextDouble() - 1.0);
+            }
+            realPointers_[n] = real_[n];
+            imagPointers_[n] = imag_[n];
+            weights_[n] = (SpectralSample)(0.5 + 0.5 * random.nextDouble()) / numSpectra;
+        }
+
+        HRTFBlendKernels::blend(realPointers_, imagPointers_, weights_, numSpectra, numBins, delayPhaseIncrement, blended_);
+        HRTFBlendKernels::blendReference(realPointers_, imagPointers_, weights_, numSpectra, numBins, delayPhaseIncrement, reference_);
+
+        double maxDifference = 0.0;
+        double maxMagnitude = 0.0;
+        for (int i = 0; i < numBins; i++)
+        {
+            maxDifference = jmax(maxDifference, std::abs((double)blended_[i][0] - reference_[i][0]), std::abs((double)blended_[i][1] - reference_[i][1]));
+            maxMagnitude = jmax(maxMagnitude, std::abs((double)reference_[i][0]), std::abs((double)reference_[i][1]));
+        }
+        return maxMagnitude > 0.0 ? maxDifference / maxMagnitude : maxDifference;
+    }
+
+    SpectralSample real_[HRTF_BLEND_MAX_SPECTRA][HRTF_BLEND_TEST_MAX_BINS];
+    SpectralSample imag_[HRTF_BLEND_MAX_SPECTRA][HRTF_BLEND_TEST_MAX_BINS];
+    const SpectralSample* realPointers_[HRTF_BLEND_MAX_SPECTRA];
+    const SpectralSample* imagPointers_[HRTF_BLEND_MAX_SPECTRA];
+    SpectralSample weights_[HRTF_BLEND_MAX_SPECTRA];
+    SpectralComplex blended_[HRTF_BLEND_TEST_MAX_BINS];
+    SpectralComplex reference_[HRTF_BLEND_TEST_MAX_BINS];
+};
+
+static HRTFBlendKernelsTest hrtfBlendKernelsTest;
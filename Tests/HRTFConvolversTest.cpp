@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/HRTFConvolver.h"
+#include "../Source/HRTFPartitionedConvolver.h"
+#include "../Source/HRTFHybridConvolver.h"
+
+// Length of each run, the sample at which the second filter is loaded, and the crossfade length given to every convolver
+#define HRTF_CONVOLVERS_TEST_NUM_SAMPLES 8192
+#define HRTF_CONVOLVERS_TEST_LOAD_SAMPLE 3000
+#define HRTF_CONVOLVERS_TEST_CROSSFADE 300
+
+// Checks the partitioned and hybrid convolvers against the direct FIR, over random block lengths and a change of filter part way through, and the latency each reports
+class HRTFConvolversTest  : public UnitTest
+{
+public:
+    HRTFConvolversTest() : UnitTest ("HRTFConvolvers", "DAFX") {}
+
+    void runTest() override
+    {
+        // Fixed seed, so a failure is repeatable
+        Random random (1);
+        for (int f = 0; f < 2; ++f)
+        {
+            for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+            {
+                for (int i = 0; i < HRIR_SIZE; ++i)
+                {
+                    filters_[f].coefficients[ear][i] = (random.nextFloat() * 2.0f - 1.0f) * std::exp(-i / 64.0f);
+                }
+            }
+        }
+
+        beginTest ("Partitioned convolver without latency when blocks are whole partitions");
+
+        for (int blockSize : { 32, 64, 128, 256, 512 })
+        {
+            HRTFPartitionedConvolver partitioned;
+            partitioned.prepare(blockSize, HRTF_CONVOLVERS_TEST_CROSSFADE);
+            expectEquals (partitioned.getLatencySamples(), 0);
+
+            // Starting its crossfade where the direct FIR does, it matches it throughout
+            expectLessThan (measureError(partitioned, blockSize, random, false), 1.0e-4, "block size " + String(blockSize));
+        }
+
+        beginTest ("Partitioned convolver with a partition of latency otherwise");
+
+        for (int blockSize : { 16, 96, 480 })
+        {
+            HRTFPartitionedConvolver partitioned;
+            partitioned.prepare(blockSize, HRTF_CONVOLVERS_TEST_CROSSFADE);
+            expectEquals (partitioned.getLatencySamples(), partitioned.getPartitionSize());
+
+            expectLessThan (measureError(partitioned, blockSize, random, true), 1.0e-4, "block size " + String(blockSize));
+        }
+
+        beginTest ("Hybrid convolver without latency");
+
+        for (int blockSize : { 32, 64, 128 })
+        {
+            HRTFHybridConvolver hybrid;
+            hybrid.prepare(blockSize, HRTF_CONVOLVERS_TEST_CROSSFADE);
+            expect (hybrid.getNumStages() > 0);
+            expectEquals (hybrid.getLatencySamples(), 0);
+
+            expectLessThan (measureError(hybrid, blockSize, random, true), 1.0e-4, "block size " + String(blockSize));
+        }
+    }
+
+private:
+    /*
+      * @brief Run a convolver and the direct FIR over the same noise, in blocks of random length, loading the second filter into both part way through
+      * @param Convolver, prepared but with no filter loaded
+      * @param Largest block length
+      * @param Source of the noise and block lengths
+      * @param Whether to leave out the crossfade, which a convolver that only changes filter at a partition boundary starts at a different sample from the direct FIR
+      * @return Largest difference between the convolver's output and the direct FIR's, delayed by the convolver's latency
+    */
+    template <typename Convolver>
+    double measureError(Convolver& convolver, int blockSize, Random& random, bool skipCrossfade)
+    {
+        HRTFConvolver direct;
+        direct.prepare(blockSize, HRTF_CONVOLVERS_TEST_CROSSFADE);
+        direct.loadFilter(filters_[0]);
+        convolver.loadFilter(filters_[0]);
+
+        const int latency = convolver.getLatencySamples();
+        std::vector<float> expected[HRIR_NUM_EARS], actual[HRIR_NUM_EARS];
+        AudioSampleBuffer directBuffer (HRIR_NUM_EARS, blockSize), buffer (HRIR_NUM_EARS, blockSize);
+        bool loaded = false;
+
+        for (int position = 0; position < HRTF_CONVOLVERS_TEST_NUM_SAMPLES; )
+        {
+            const int numSamples = 1 + random.nextInt(blockSize);
+
+            if (! loaded && position >= HRTF_CONVOLVERS_TEST_LOAD_SAMPLE)
+            {
+                direct.loadFilter(filters_[1]);
+                convolver.loadFilter(filters_[1]);
+                loaded = true;
+            }
+
+            for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const float sample = random.nextFloat() * 2.0f - 1.0f;
+                    directBuffer.setSample(ear, i, sample);
+                    buffer.setSample(ear, i, sample);
+                }
+            }
+
+            direct.process(directBuffer, numSamples);
+            convolver.process(buffer, numSamples);
+
+            for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    expected[ear].push_back(directBuffer.getSample(ear, i));
+                    actual[ear].push_back(buffer.getSample(ear, i));
+                }
+            }
+            position += numSamples;
+        }
+
+        // A convolver with latency fades from the start of the partition that was filling at the load, so its fade can begin up to a partition early once lined up
+        // with the direct FIR. The load itself lands within a block of HRTF_CONVOLVERS_TEST_LOAD_SAMPLE
+        const int fadeStart = HRTF_CONVOLVERS_TEST_LOAD_SAMPLE - HRIR_SIZE;
+        const int fadeEnd = HRTF_CONVOLVERS_TEST_LOAD_SAMPLE + blockSize + HRIR_SIZE + HRTF_CONVOLVERS_TEST_CROSSFADE;
+
+        double maxDifference = 0.0;
+        for (int ear = 0; ear < HRIR_NUM_EARS; ++ear)
+        {
+            for (int n = 0; n + latency < (int)actual[ear].size(); ++n)
+            {
+                if (skipCrossfade && n >= fadeStart && n < fadeEnd)
+                    continue;
+
+                maxDifference = jmax(maxDifference, (double)std::abs(actual[ear][(size_t)(n + latency)] - expected[ear][(size_t)n]));
+            }
+        }
+        return maxDifference;
+    }
+
+    HRTFFilter filters_[2];
+};
+
+static HRTFConvolversTest hrtfConvolversTest;
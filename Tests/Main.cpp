@@ -0,0 +1,28 @@
+/*
+  ==============================================================================
+
+        DAFX BINAURAL PHASE VOCODER
+        v1.0
+        Jack Walters
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+/*
+  * @brief Run every registered unit test and report the result through the exit code, so the tests can gate a build
+*/
+int main (int argc, char* argv[])
+{
+    UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runAllTests();
+
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+    {
+        numFailures += runner.getResult(i)->failures;
+    }
+    return numFailures == 0 ? 0 : 1;
+}